@@ -0,0 +1,435 @@
+#include "antialiasing.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+const float TAA_BLEND = 0.1f;        // Доля текущего кадра в истории
+const int JITTER_SEQUENCE = 8;       // Длина цикла сдвигов
+
+const char* modeNames[AA_MODE_COUNT] = {"off", "msaa", "fxaa", "taa"};
+
+const char* fullscreenVertexShader = R"(
+    #version 330 core
+    void main() {
+        vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+        gl_Position = vec4(position, 0.0, 1.0);
+    }
+)";
+
+// FXAA в упрощённом варианте Т. Лоттса: направление края по яркости углов,
+// две и четыре выборки вдоль него; если четыре вылезли за диапазон соседей — берём две.
+// Кадр в HDR, поэтому яркость считается по сжатому цвету c / (1 + c) — как после тональной кривой
+const char* fxaaFragmentShader = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    uniform sampler2D sceneColor;
+    uniform vec2 inverseSize;
+
+    const float REDUCE_MIN = 1.0 / 128.0;
+    const float REDUCE_MUL = 1.0 / 8.0;
+    const float SPAN_MAX = 8.0;
+    const vec3 LUMA = vec3(0.299, 0.587, 0.114);
+
+    vec3 sampleScene(vec2 uv) {
+        return texture(sceneColor, uv).rgb;
+    }
+
+    float luma(vec3 color) {
+        return dot(color / (1.0 + color), LUMA);
+    }
+
+    void main() {
+        vec2 uv = gl_FragCoord.xy * inverseSize;
+        float lumaNW = luma(sampleScene(uv + vec2(-1.0, -1.0) * inverseSize));
+        float lumaNE = luma(sampleScene(uv + vec2(1.0, -1.0) * inverseSize));
+        float lumaSW = luma(sampleScene(uv + vec2(-1.0, 1.0) * inverseSize));
+        float lumaSE = luma(sampleScene(uv + vec2(1.0, 1.0) * inverseSize));
+        vec3 colorM = sampleScene(uv);
+        float lumaM = luma(colorM);
+        float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+        float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+        vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+        float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * REDUCE_MUL, REDUCE_MIN);
+        float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+        dir = clamp(dir * rcpDirMin, vec2(-SPAN_MAX), vec2(SPAN_MAX)) * inverseSize;
+
+        vec3 colorA = 0.5 * (sampleScene(uv + dir * (1.0 / 3.0 - 0.5)) + sampleScene(uv + dir * (2.0 / 3.0 - 0.5)));
+        vec3 colorB = colorA * 0.5 + 0.25 * (sampleScene(uv - dir * 0.5) + sampleScene(uv + dir * 0.5));
+        float lumaB = luma(colorB);
+        FragColor = vec4((lumaB < lumaMin || lumaB > lumaMax) ? colorA : colorB, 1.0);
+    }
+)";
+
+// TAA: позиция пикселя восстанавливается по глубине и проецируется матрицами этого
+// и прошлого кадра без сдвига. Разница — вектор движения (только от камеры; движущиеся
+// объекты отсекает зажим истории по соседям). У неподвижной камеры он нулевой,
+// и история читается точно в своих пикселях, а не со сдвигом этого кадра
+const char* taaFragmentShader = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    uniform sampler2D sceneColor;
+    uniform sampler2D sceneDepth;
+    uniform sampler2D history;
+    uniform mat4 inverseViewProjection;    // Текущий кадр, со сдвигом (так лежит глубина)
+    uniform mat4 currentViewProjection;    // Текущий кадр, без сдвига
+    uniform mat4 previousViewProjection;   // Прошлый кадр, без сдвига
+    uniform vec2 inverseSize;
+    uniform bool historyValid;
+    uniform float blendFactor;
+
+    void main() {
+        vec2 uv = gl_FragCoord.xy * inverseSize;
+        vec3 current = texture(sceneColor, uv).rgb;
+
+        // Диапазон соседей 3×3 — в него зажимается история
+        vec3 neighborMin = current;
+        vec3 neighborMax = current;
+        for (int y = -1; y <= 1; ++y) {
+            for (int x = -1; x <= 1; ++x) {
+                vec3 neighbor = texture(sceneColor, uv + vec2(x, y) * inverseSize).rgb;
+                neighborMin = min(neighborMin, neighbor);
+                neighborMax = max(neighborMax, neighbor);
+            }
+        }
+
+        float depth = texture(sceneDepth, uv).r;
+        vec4 worldPos = inverseViewProjection * vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+        vec3 position = worldPos.xyz / worldPos.w;
+        vec4 currentClip = currentViewProjection * vec4(position, 1.0);
+        vec4 previousClip = previousViewProjection * vec4(position, 1.0);
+        vec2 motion = (currentClip.xy / currentClip.w - previousClip.xy / previousClip.w) * 0.5;
+        vec2 previousUv = uv - motion;
+
+        if (!historyValid || previousClip.w <= 0.0 || any(lessThan(previousUv, vec2(0.0))) || any(greaterThan(previousUv, vec2(1.0)))) {
+            FragColor = vec4(current, 1.0);
+            return;
+        }
+
+        vec3 previous = clamp(texture(history, previousUv).rgb, neighborMin, neighborMax);
+        FragColor = vec4(mix(previous, current, blendFactor), 1.0);
+    }
+)";
+
+GLuint compileShader(GLenum type, const char* source, const char* name) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << name << " shader compilation failed:\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+GLuint linkProgram(const char* fragmentSource, const char* name) {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, fullscreenVertexShader, name);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, name);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << name << " program linking failed:\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+GLuint createTexture(GLenum internalFormat, GLenum format, GLenum type, int width, int height) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+bool framebufferComplete(const char* name) {
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << name << " framebuffer is incomplete" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Радикальная обратная последовательность: равномерно заполняет отрезок [0, 1)
+float halton(int index, int base) {
+    float result = 0.0f;
+    float fraction = 1.0f / base;
+    for (; index > 0; index /= base) {
+        result += fraction * (index % base);
+        fraction /= base;
+    }
+    return result;
+}
+
+} // namespace
+
+const char* antiAliasingName(AntiAliasingMode mode) {
+    return modeNames[mode];
+}
+
+bool parseAntiAliasingMode(const std::string& name, AntiAliasingMode& mode) {
+    for (int i = 0; i < AA_MODE_COUNT; ++i) {
+        if (name == modeNames[i]) {
+            mode = AntiAliasingMode(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AntiAliasing::init(int viewportWidth, int viewportHeight, AntiAliasingMode initialMode, int msaaSamples) {
+    width = viewportWidth;
+    height = viewportHeight;
+    samples = msaaSamples;
+    bool complete = true;
+
+    // Глубина в том же формате, что у окна, — частицы копируют её blit-ом
+    sceneColor = createTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT, width, height);
+    sceneDepth = createTexture(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, width, height);
+    glBindTexture(GL_TEXTURE_2D, sceneDepth);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &sceneFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColor, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, sceneDepth, 0);
+    complete = framebufferComplete("Anti-aliasing scene") && complete;
+
+    glGenRenderbuffers(1, &msaaColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, msaaColor);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA16F, width, height);
+    glGenRenderbuffers(1, &msaaDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, msaaDepth);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &msaaFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, msaaFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, msaaColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, msaaDepth);
+    complete = framebufferComplete("MSAA") && complete;
+
+    // История в той же точности, что и кадр (HDR)
+    for (int i = 0; i < 2; ++i) {
+        historyTextures[i] = createTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT, width, height);
+        glGenFramebuffers(1, &historyFramebuffers[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, historyFramebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, historyTextures[i], 0);
+        complete = framebufferComplete("TAA history") && complete;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    fxaaProgram = linkProgram(fxaaFragmentShader, "FXAA");
+    taaProgram = linkProgram(taaFragmentShader, "TAA");
+    glUseProgram(fxaaProgram);
+    glUniform1i(glGetUniformLocation(fxaaProgram, "sceneColor"), 0);
+    glUseProgram(taaProgram);
+    glUniform1i(glGetUniformLocation(taaProgram, "sceneColor"), 0);
+    glUniform1i(glGetUniformLocation(taaProgram, "sceneDepth"), 1);
+    glUniform1i(glGetUniformLocation(taaProgram, "history"), 2);
+    glUseProgram(0);
+    glGenVertexArrays(1, &emptyVAO);
+
+    for (TimerSlot& slot : timers) {
+        glGenQueries(3, slot.queries);
+    }
+
+    setMode(initialMode);
+    return complete;
+}
+
+void AntiAliasing::destroy() {
+    for (TimerSlot& slot : timers) {
+        glDeleteQueries(3, slot.queries);
+        slot.pending = false;
+    }
+    glDeleteFramebuffers(1, &sceneFramebuffer);
+    glDeleteFramebuffers(1, &msaaFramebuffer);
+    glDeleteFramebuffers(2, historyFramebuffers);
+    GLuint textures[] = {sceneColor, sceneDepth, historyTextures[0], historyTextures[1]};
+    glDeleteTextures(4, textures);
+    GLuint renderbuffers[] = {msaaColor, msaaDepth};
+    glDeleteRenderbuffers(2, renderbuffers);
+    glDeleteProgram(fxaaProgram);
+    glDeleteProgram(taaProgram);
+    glDeleteVertexArrays(1, &emptyVAO);
+}
+
+void AntiAliasing::setMode(AntiAliasingMode newMode) {
+    currentMode = newMode;
+    historyValid = false;
+}
+
+glm::mat4 AntiAliasing::jitter(const glm::mat4& unjittered) {
+    projection = unjittered;
+    jitteredProjection = unjittered;
+    if (currentMode == AA_TAA) {
+        // Сдвиг в пределах пикселя, в координатах NDC
+        int index = frameIndex % JITTER_SEQUENCE + 1;
+        glm::vec2 offset(halton(index, 2) - 0.5f, halton(index, 3) - 0.5f);
+        jitteredProjection[2][0] += offset.x * 2.0f / width;
+        jitteredProjection[2][1] += offset.y * 2.0f / height;
+    }
+    return jitteredProjection;
+}
+
+void AntiAliasing::collectTimers(TimerSlot& slot) {
+    if (!slot.pending) {
+        return;
+    }
+    // Кадр был несколько кадров назад — результат почти всегда уже готов
+    GLuint64 stamps[3];
+    for (int i = 0; i < 3; ++i) {
+        glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &stamps[i]);
+    }
+    ModeCost& cost = costs[slot.mode];
+    cost.frames++;
+    cost.sceneMilliseconds += (stamps[1] - stamps[0]) / 1.0e6;
+    cost.resolveMilliseconds += (stamps[2] - stamps[1]) / 1.0e6;
+    slot.pending = false;
+}
+
+GLuint AntiAliasing::beginFrame(GLuint output) {
+    outputFramebuffer = output;
+
+    TimerSlot& slot = timers[timerIndex];
+    collectTimers(slot);
+    slot.mode = currentMode;
+    glQueryCounter(slot.queries[0], GL_TIMESTAMP);
+
+    switch (currentMode) {
+        case AA_MSAA:
+            return msaaFramebuffer;
+        case AA_FXAA:
+        case AA_TAA:
+            return sceneFramebuffer;
+        default:
+            return outputFramebuffer;
+    }
+}
+
+void AntiAliasing::drawFullscreen() {
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+}
+
+void AntiAliasing::resolve(const glm::mat4& view) {
+    TimerSlot& slot = timers[timerIndex];
+    glQueryCounter(slot.queries[1], GL_TIMESTAMP);
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glViewport(0, 0, width, height);
+    glm::vec2 inverseSize(1.0f / width, 1.0f / height);
+
+    switch (currentMode) {
+        case AA_MSAA:
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, msaaFramebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+            glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            break;
+
+        case AA_FXAA:
+            glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+            glUseProgram(fxaaProgram);
+            glUniform2fv(glGetUniformLocation(fxaaProgram, "inverseSize"), 1, glm::value_ptr(inverseSize));
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, sceneColor);
+            drawFullscreen();
+            break;
+
+        case AA_TAA: {
+            int write = historyIndex;
+            int read = 1 - historyIndex;
+            glm::mat4 inverseViewProjection = glm::inverse(jitteredProjection * view);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, historyFramebuffers[write]);
+            glUseProgram(taaProgram);
+            glUniformMatrix4fv(glGetUniformLocation(taaProgram, "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+            glm::mat4 currentViewProjection = projection * view;
+            glUniformMatrix4fv(glGetUniformLocation(taaProgram, "currentViewProjection"), 1, GL_FALSE, glm::value_ptr(currentViewProjection));
+            glUniformMatrix4fv(glGetUniformLocation(taaProgram, "previousViewProjection"), 1, GL_FALSE, glm::value_ptr(previousViewProjection));
+            glUniform2fv(glGetUniformLocation(taaProgram, "inverseSize"), 1, glm::value_ptr(inverseSize));
+            glUniform1i(glGetUniformLocation(taaProgram, "historyValid"), historyValid ? 1 : 0);
+            glUniform1f(glGetUniformLocation(taaProgram, "blendFactor"), TAA_BLEND);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, sceneColor);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, sceneDepth);
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, historyTextures[read]);
+            glActiveTexture(GL_TEXTURE0);
+            drawFullscreen();
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, historyFramebuffers[write]);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+            glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+            historyIndex = read;
+            historyValid = true;
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+
+    glQueryCounter(slot.queries[2], GL_TIMESTAMP);
+    slot.pending = true;
+    timerIndex = (timerIndex + 1) % TIMER_FRAMES;
+
+    previousViewProjection = projection * view;
+    ++frameIndex;
+}
+
+void AntiAliasing::printCosts() {
+    for (TimerSlot& slot : timers) {
+        collectTimers(slot);
+    }
+    std::cout << "Anti-aliasing GPU cost, ms per frame:" << std::endl;
+    std::cout << std::left << std::setw(8) << "  mode" << std::right << std::setw(8) << "frames"
+              << std::setw(10) << "scene" << std::setw(10) << "resolve" << std::setw(10) << "total" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (int i = 0; i < AA_MODE_COUNT; ++i) {
+        const ModeCost& cost = costs[i];
+        if (cost.frames == 0) {
+            continue;
+        }
+        double scene = cost.sceneMilliseconds / cost.frames;
+        double resolve = cost.resolveMilliseconds / cost.frames;
+        std::cout << "  " << std::left << std::setw(6) << modeNames[i] << std::right << std::setw(8) << cost.frames
+                  << std::setw(10) << scene << std::setw(10) << resolve << std::setw(10) << scene + resolve << std::endl;
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// Сглаживание, выбираемое на ходу, вместо MSAA у буфера окна.
+// Все цели — RGBA16F: сглаживается HDR-кадр, выходной буфер — HDR-цель PostProcess.
+// - OFF  — сцена рисуется прямо в выходной буфер.
+// - MSAA — сцена в многосэмпловую цель (4x), затем resolve blit-ом.
+// - FXAA — один полноэкранный проход по готовому кадру (поиск краёв по яркости).
+// - TAA  — проекция сдвигается на субпиксель (последовательность Halton 2,3),
+//   прошлый кадр перепроецируется по глубине и матрицам камеры (вектор движения
+//   для каждого пикселя), а история зажимается в диапазон соседей 3×3 текущего кадра.
+// Время на видеокарте меряется метками времени (GL_TIMESTAMP) отдельно для сцены
+// и для прохода сглаживания и копится по режимам — сводку печатает printCosts().
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+
+enum AntiAliasingMode {
+    AA_OFF,
+    AA_MSAA,
+    AA_FXAA,
+    AA_TAA,
+    AA_MODE_COUNT
+};
+
+const char* antiAliasingName(AntiAliasingMode mode);
+// "off", "msaa", "fxaa", "taa"
+bool parseAntiAliasingMode(const std::string& name, AntiAliasingMode& mode);
+
+class AntiAliasing {
+public:
+    bool init(int viewportWidth, int viewportHeight, AntiAliasingMode initialMode, int msaaSamples = 4);
+    void destroy();
+
+    // Смена режима сбрасывает историю TAA
+    void setMode(AntiAliasingMode newMode);
+    AntiAliasingMode mode() const { return currentMode; }
+
+    // Проекция кадра со сдвигом TAA (в остальных режимах — без изменений).
+    // Вызывать раз за кадр с несдвинутой проекцией, до отрисовки
+    glm::mat4 jitter(const glm::mat4& projection);
+
+    // Буфер, в который рисовать сцену в этом кадре; output — куда попадёт итог
+    GLuint beginFrame(GLuint output);
+    // Сглаживание и вывод в output. view — камера этого кадра (для перепроецирования)
+    void resolve(const glm::mat4& view);
+
+    // Среднее время сцены и сглаживания по каждому режиму, в котором были кадры.
+    // Дочитывает метки последних кадров, поэтому вызывать в конце
+    void printCosts();
+
+private:
+    int width = 0;
+    int height = 0;
+    int samples = 4;
+    AntiAliasingMode currentMode = AA_OFF;
+    GLuint outputFramebuffer = 0;
+
+    // Цель без мультисэмплинга для FXAA и TAA: цвет и глубина — текстуры
+    GLuint sceneFramebuffer = 0;
+    GLuint sceneColor = 0;
+    GLuint sceneDepth = 0;
+    // Многосэмпловая цель
+    GLuint msaaFramebuffer = 0;
+    GLuint msaaColor = 0;
+    GLuint msaaDepth = 0;
+    // История TAA: пишем в одну, читаем другую
+    GLuint historyFramebuffers[2] = {0, 0};
+    GLuint historyTextures[2] = {0, 0};
+    int historyIndex = 0;
+    bool historyValid = false;
+
+    GLuint fxaaProgram = 0;
+    GLuint taaProgram = 0;
+    GLuint emptyVAO = 0;
+
+    int frameIndex = 0;
+    glm::mat4 projection = glm::mat4(1.0f);            // Без сдвига
+    glm::mat4 jitteredProjection = glm::mat4(1.0f);
+    glm::mat4 previousViewProjection = glm::mat4(1.0f);
+
+    // Метки времени: начало кадра, начало сглаживания, конец. Кольцо на несколько кадров,
+    // чтобы результат читать, когда он уже готов, не останавливая конвейер
+    static const int TIMER_FRAMES = 4;
+    struct TimerSlot {
+        GLuint queries[3] = {0, 0, 0};
+        AntiAliasingMode mode = AA_OFF;
+        bool pending = false;
+    };
+    TimerSlot timers[TIMER_FRAMES];
+    int timerIndex = 0;
+
+    struct ModeCost {
+        int frames = 0;
+        double sceneMilliseconds = 0.0;
+        double resolveMilliseconds = 0.0;
+    };
+    ModeCost costs[AA_MODE_COUNT];
+
+    void collectTimers(TimerSlot& slot);
+    void drawFullscreen();
+};
@@ -0,0 +1,215 @@
+// Пакетный прогон сценариев доставки без окна и OpenGL.
+// Каждый мир получает своё зерно (seed, seed+1, ...) и шагает с фиксированным dt
+// так быстро, как позволяет процессор; миры раздаются потокам по одному.
+// В конце печатается сводка (среднее, минимум, максимум, разброс) и при желании CSV по мирам.
+
+#include "simulation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BatchOptions {
+    int worlds = 64;
+    float seconds = 120.0f;       // Игровое время каждого мира
+    int stepsPerSecond = 60;
+    uint32_t seed = 1;
+    unsigned threads = 0;         // 0 — по числу ядер
+    std::string scriptPath;       // Сценарий для дирижабля игрока; без него игрок на автопилоте
+    std::string csvPath;
+    WorldSettings world;
+};
+
+struct RunResult {
+    uint32_t seed = 0;
+    WorldStats stats;
+    double wallMilliseconds = 0.0;
+    double worstStepMilliseconds = 0.0;
+};
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void printUsage(const char* program) {
+    std::cout << "Использование: " << program << " [--worlds N] [--seconds S] [--rate N] [--seed N]"
+              << " [--threads N] [--fleet N] [--clouds N] [--balloons N] [--targets N]"
+              << " [--script файл] [--csv файл]" << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, BatchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--worlds" && hasValue) {
+            options.worlds = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--seconds" && hasValue) {
+            options.seconds = std::max(0.0f, float(atof(argv[++i])));
+        } else if (arg == "--rate" && hasValue) {
+            options.stepsPerSecond = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::max(0, atoi(argv[++i])));
+        } else if (arg == "--fleet" && hasValue) {
+            options.world.fleetSize = std::min(std::max(0, atoi(argv[++i])), int(MAX_AIRSHIPS) - 1);
+        } else if (arg == "--clouds" && hasValue) {
+            options.world.cloudCount = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--balloons" && hasValue) {
+            options.world.balloonCount = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--targets" && hasValue) {
+            options.world.targetCount = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--script" && hasValue) {
+            options.scriptPath = argv[++i];
+        } else if (arg == "--csv" && hasValue) {
+            options.csvPath = argv[++i];
+        } else {
+            std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+RunResult runWorld(const BatchOptions& options, uint32_t seed, InputScript script) {
+    RunResult run;
+    run.seed = seed;
+    Clock::time_point start = Clock::now();
+
+    WorldSettings settings = options.world;
+    settings.seed = seed;
+    settings.playerAutopilot = script.empty();
+    World world;
+    initWorld(world, settings);
+
+    float deltaTime = 1.0f / options.stepsPerSecond;
+    long steps = std::lround(options.seconds * options.stepsPerSecond);
+    for (long step = 0; step < steps; ++step) {
+        InputState input = script.next(world.timeElapsed + deltaTime);
+        Clock::time_point stepStart = Clock::now();
+        stepWorld(world, input, deltaTime);
+        run.worstStepMilliseconds = std::max(run.worstStepMilliseconds, millisecondsSince(stepStart));
+    }
+
+    run.stats = world.stats;
+    run.wallMilliseconds = millisecondsSince(start);
+    return run;
+}
+
+// Среднее, минимум, максимум и стандартное отклонение по мирам
+void printRow(const char* name, const std::vector<RunResult>& runs, double (*value)(const RunResult&)) {
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    double low = value(runs.front());
+    double high = low;
+    for (const RunResult& run : runs) {
+        double x = value(run);
+        sum += x;
+        sumSquares += x * x;
+        low = std::min(low, x);
+        high = std::max(high, x);
+    }
+    double mean = sum / runs.size();
+    double deviation = std::sqrt(std::max(0.0, sumSquares / runs.size() - mean * mean));
+    std::cout << std::left << std::setw(22) << name << std::right
+              << std::setw(10) << mean << std::setw(10) << low
+              << std::setw(10) << high << std::setw(10) << deviation << std::endl;
+}
+
+bool writeCsv(const std::string& path, const std::vector<RunResult>& runs) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    file << "seed,deliveries,parcels_dropped,parcels_missed,cloud_encounters,plans_applied,planning_ms,wall_ms,worst_step_ms\n";
+    for (const RunResult& run : runs) {
+        file << run.seed << ',' << run.stats.deliveries << ',' << run.stats.parcelsDropped << ','
+             << run.stats.parcelsMissed << ',' << run.stats.cloudEncounters << ',' << run.stats.plansApplied << ','
+             << run.stats.planningMilliseconds << ',' << run.wallMilliseconds << ',' << run.worstStepMilliseconds << '\n';
+    }
+    return bool(file);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BatchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    InputScript script;
+    if (!options.scriptPath.empty()) {
+        std::string error;
+        if (!script.load(options.scriptPath, error)) {
+            std::cerr << "Failed to load input script: " << error << std::endl;
+            return -1;
+        }
+    }
+
+    // Миры уже параллельны между собой, поэтому каждый планирует маршруты в один поток
+    // и дожидается ответа в том же шаге — результат зависит только от зерна
+    options.world.plannerThreads = 1;
+    options.world.synchronousPlanning = true;
+
+    unsigned threadCount = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, unsigned(options.worlds));
+
+    std::vector<RunResult> runs(options.worlds);
+    std::atomic<int> nextWorld{0};
+    Clock::time_point start = Clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&] {
+            for (int i = nextWorld++; i < options.worlds; i = nextWorld++) {
+                runs[i] = runWorld(options, options.seed + uint32_t(i), script);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    double wallSeconds = millisecondsSince(start) / 1000.0;
+    double simulatedSeconds = double(options.seconds) * options.worlds;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Worlds: " << options.worlds << " x " << options.seconds << " s at " << options.stepsPerSecond
+              << " steps/s, seeds " << options.seed << ".." << options.seed + uint32_t(options.worlds - 1)
+              << ", " << threadCount << " threads" << std::endl;
+    std::cout << "Wall time: " << wallSeconds << " s, " << simulatedSeconds / std::max(wallSeconds, 1e-6)
+              << "x real time" << std::endl;
+    std::cout << std::left << std::setw(22) << "" << std::right << std::setw(10) << "mean" << std::setw(10) << "min"
+              << std::setw(10) << "max" << std::setw(10) << "stddev" << std::endl;
+    printRow("deliveries", runs, [](const RunResult& run) { return double(run.stats.deliveries); });
+    printRow("parcels dropped", runs, [](const RunResult& run) { return double(run.stats.parcelsDropped); });
+    printRow("parcels missed", runs, [](const RunResult& run) { return double(run.stats.parcelsMissed); });
+    printRow("cloud encounters", runs, [](const RunResult& run) { return double(run.stats.cloudEncounters); });
+    printRow("plans applied", runs, [](const RunResult& run) { return double(run.stats.plansApplied); });
+    printRow("planner ms per plan", runs, [](const RunResult& run) {
+        return run.stats.plansApplied ? run.stats.planningMilliseconds / run.stats.plansApplied : 0.0;
+    });
+    printRow("world wall ms", runs, [](const RunResult& run) { return run.wallMilliseconds; });
+    printRow("worst step ms", runs, [](const RunResult& run) { return run.worstStepMilliseconds; });
+
+    if (!options.csvPath.empty() && !writeCsv(options.csvPath, runs)) {
+        std::cerr << "Failed to write " << options.csvPath << std::endl;
+        return -1;
+    }
+    return 0;
+}
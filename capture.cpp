@@ -0,0 +1,394 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+const size_t MAX_QUEUED_FRAMES = 8;   // Дальше основной поток ждёт кодировщик, а не копит память
+
+// CRC-32 для чанков PNG
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t adler32(uint32_t adler, const uint8_t* data, size_t size) {
+    uint32_t a = adler & 0xFFFF, b = adler >> 16;
+    while (size > 0) {
+        size_t block = std::min<size_t>(size, 5552);   // Больше — и b переполнится до взятия остатка
+        size -= block;
+        while (block--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(uint8_t(value >> 24));
+    out.push_back(uint8_t(value >> 16));
+    out.push_back(uint8_t(value >> 8));
+    out.push_back(uint8_t(value));
+}
+
+bool writeChunk(FILE* file, const char* type, const uint8_t* data, size_t size) {
+    uint8_t header[8] = {
+        uint8_t(size >> 24), uint8_t(size >> 16), uint8_t(size >> 8), uint8_t(size),
+        uint8_t(type[0]), uint8_t(type[1]), uint8_t(type[2]), uint8_t(type[3])
+    };
+    uint32_t crc = crc32(header + 4, 4);
+    crc = crc32(data, size, crc);
+    uint8_t footer[4] = {uint8_t(crc >> 24), uint8_t(crc >> 16), uint8_t(crc >> 8), uint8_t(crc)};
+    return fwrite(header, 1, 8, file) == 8 &&
+           (size == 0 || fwrite(data, 1, size, file) == size) &&
+           fwrite(footer, 1, 4, file) == 4;
+}
+
+} // namespace
+
+bool FrameCapture::start(const std::string& path, int frameWidth, int frameHeight, int fps, int ringDepth) {
+    outputPath = path;
+    width = frameWidth;
+    height = frameHeight;
+    framesPerSecond = fps;
+    y4m = path.size() > 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+
+    if (y4m) {
+        stream = fopen(path.c_str(), "wb");
+        if (!stream) {
+            std::cerr << "Cannot open " << path << " for recording" << std::endl;
+            return false;
+        }
+        // Без XCOLORRANGE читатели (ffmpeg) считают диапазон ограниченным и сжимают контраст
+        fprintf(stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", width, height, fps);
+    } else {
+        std::error_code error;
+        std::filesystem::create_directories(path, error);
+        if (error) {
+            std::cerr << "Cannot create " << path << ": " << error.message() << std::endl;
+            return false;
+        }
+    }
+
+    size_t frameBytes = size_t(width) * height * 4;
+    ring.resize(std::max(ringDepth, 2));
+    for (auto& slot : ring) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Кадры для кодировщика выделяются заранее: полная очередь, плюс кадр, который
+    // кодируется, и кадр, который заполняет основной поток
+    queue.resize(MAX_QUEUED_FRAMES);
+    queueHead = 0;
+    queueSize = 0;
+    freeBuffers.reserve(MAX_QUEUED_FRAMES + 2);
+    freeBuffers.resize(MAX_QUEUED_FRAMES + 2);
+    for (auto& buffer : freeBuffers) {
+        buffer.resize(frameBytes);
+    }
+
+    head = 0;
+    inFlight = 0;
+    frameCounter = 0;
+    mainThreadMilliseconds = 0.0;
+    ringStalls = 0;
+    encoderStalls = 0;
+    stopping = false;
+    recording = true;
+    encoder = std::thread(&FrameCapture::encoderLoop, this);
+    return true;
+}
+
+void FrameCapture::capture(GLuint sourceFramebuffer) {
+    if (!recording) {
+        return;
+    }
+    auto begin = std::chrono::steady_clock::now();
+
+    // Сначала забираем все кадры, которые видеокарта уже дочитала
+    while (inFlight > 0 && collect(false)) {
+    }
+    // Кольцо всё ещё занято целиком — дожидаемся самого старого кадра (это и есть остановка конвейера)
+    if (inFlight == ring.size()) {
+        ++ringStalls;
+        collect(true);
+    }
+
+    ReadbackSlot& slot = ring[head];
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sourceFramebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frame = frameCounter++;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, sourceFramebuffer);
+
+    head = (head + 1) % ring.size();
+    ++inFlight;
+
+    mainThreadMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+bool FrameCapture::collect(bool wait) {
+    ReadbackSlot& slot = ring[(head + ring.size() - inFlight) % ring.size()];
+
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (wait && status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);   // 100 мс
+    }
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+    --inFlight;
+
+    size_t frameBytes = size_t(width) * height * 4;
+    EncodedFrame frame;
+    frame.index = slot.frame;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeBuffers.empty()) {
+            frame.pixels = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+    frame.pixels.resize(frameBytes);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* source = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT);
+    bool mapped = source != nullptr;
+    if (mapped) {
+        std::memcpy(frame.pixels.data(), source, frameBytes);
+        mapped = glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!mapped) {
+        std::cerr << "Frame " << frame.index << " readback failed, skipped" << std::endl;
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.push_back(std::move(frame.pixels));   // Буфер возвращается в запас, иначе следующий кадр выделит новый
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (queueSize == MAX_QUEUED_FRAMES) {
+        ++encoderStalls;
+        drained.wait(lock, [this] { return queueSize < MAX_QUEUED_FRAMES; });
+    }
+    queue[(queueHead + queueSize) % MAX_QUEUED_FRAMES] = std::move(frame);
+    ++queueSize;
+    lock.unlock();
+    wake.notify_one();
+    return true;
+}
+
+void FrameCapture::finish() {
+    if (!recording) {
+        return;
+    }
+    while (inFlight > 0) {
+        collect(true);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    encoder.join();
+
+    if (stream) {
+        fclose(stream);
+        stream = nullptr;
+    }
+    for (auto& slot : ring) {
+        glDeleteBuffers(1, &slot.buffer);
+    }
+    ring.clear();
+    queue.clear();
+    freeBuffers.clear();
+    recording = false;
+
+    std::cout << "Записано кадров: " << frameCounter << " в " << outputPath
+              << " (основной поток: " << (frameCounter ? mainThreadMilliseconds / frameCounter : 0.0) << " мс/кадр"
+              << ", ожиданий видеокарты: " << ringStalls << ", ожиданий кодировщика: " << encoderStalls << ")" << std::endl;
+}
+
+void FrameCapture::encoderLoop() {
+    bool failed = false;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || queueSize > 0; });
+        if (queueSize == 0) {
+            return;   // stopping и всё записано
+        }
+
+        EncodedFrame frame = std::move(queue[queueHead]);
+        queueHead = (queueHead + 1) % MAX_QUEUED_FRAMES;
+        --queueSize;
+        lock.unlock();
+
+        bool written = y4m ? writeY4mFrame(frame) : writePng(frame);
+        if (!written && !failed) {
+            std::cerr << "Failed to write frame " << frame.index << " to " << outputPath << std::endl;
+            failed = true;
+        }
+
+        lock.lock();
+        freeBuffers.push_back(std::move(frame.pixels));
+        drained.notify_all();
+    }
+}
+
+// PNG без сжатия (deflate stored-блоки): кодировщик обязан успевать за 60 кадрами в секунду,
+// а сжимать запись удобнее потом (ffmpeg, optipng)
+bool FrameCapture::writePng(const EncodedFrame& frame) {
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(frame.index));
+    std::string path = (std::filesystem::path(outputPath) / name).string();
+
+    // Строки сверху вниз, у каждой байт фильтра 0, RGB без альфы
+    size_t rowBytes = size_t(width) * 3 + 1;
+    size_t rawBytes = rowBytes * height;
+    size_t blockCount = (rawBytes + 65534) / 65535;
+
+    std::vector<uint8_t>& idat = encodeScratch;
+    idat.clear();
+    idat.reserve(2 + blockCount * 5 + rawBytes + 4);
+    idat.push_back(0x78);   // zlib: deflate, окно 32 КБ
+    idat.push_back(0x01);
+
+    size_t rawStart = idat.size() + 5;   // Первые данные идут после заголовка первого блока
+    size_t remaining = rawBytes;
+    size_t row = 0, column = 0;
+    while (remaining > 0) {
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>(remaining, 65535));
+        remaining -= length;
+        idat.push_back(remaining == 0 ? 1 : 0);
+        idat.push_back(uint8_t(length));
+        idat.push_back(uint8_t(length >> 8));
+        idat.push_back(uint8_t(~length));
+        idat.push_back(uint8_t(~length >> 8));
+
+        for (uint16_t i = 0; i < length; ++i) {
+            if (column == 0) {
+                idat.push_back(0);
+            } else {
+                const uint8_t* pixel = frame.pixels.data() + ((height - 1 - row) * size_t(width) + (column - 1) / 3) * 4;
+                idat.push_back(pixel[(column - 1) % 3]);
+            }
+            if (++column == rowBytes) {
+                column = 0;
+                ++row;
+            }
+        }
+    }
+
+    // Adler-32 считается по несжатым данным, без заголовков блоков
+    uint32_t checksum = 1;
+    size_t position = rawStart;
+    size_t left = rawBytes;
+    while (left > 0) {
+        size_t length = std::min<size_t>(left, 65535);
+        checksum = adler32(checksum, idat.data() + position, length);
+        position += length + 5;
+        left -= length;
+    }
+    putBigEndian(idat, checksum);
+
+    uint8_t header[13];
+    uint32_t w = width, h = height;
+    for (int i = 0; i < 4; ++i) {
+        header[i] = uint8_t(w >> (24 - 8 * i));
+        header[4 + i] = uint8_t(h >> (24 - 8 * i));
+    }
+    header[8] = 8;    // Бит на канал
+    header[9] = 2;    // RGB
+    header[10] = 0;
+    header[11] = 0;
+    header[12] = 0;
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(signature, 1, 8, file) == 8 &&
+              writeChunk(file, "IHDR", header, sizeof(header)) &&
+              writeChunk(file, "IDAT", idat.data(), idat.size()) &&
+              writeChunk(file, "IEND", nullptr, 0);
+    return fclose(file) == 0 && ok;
+}
+
+// Y4M 4:2:0 (полный диапазон — XCOLORRANGE=FULL в заголовке, BT.601): яркость на каждый пиксель, цвет — среднее по квадрату 2x2
+bool FrameCapture::writeY4mFrame(const EncodedFrame& frame) {
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+    size_t lumaBytes = size_t(width) * height;
+    size_t chromaBytes = size_t(chromaWidth) * chromaHeight;
+
+    std::vector<uint8_t>& planes = encodeScratch;
+    planes.resize(lumaBytes + chromaBytes * 2);
+    uint8_t* lumaPlane = planes.data();
+    uint8_t* cbPlane = lumaPlane + lumaBytes;
+    uint8_t* crPlane = cbPlane + chromaBytes;
+
+    auto pixelAt = [&](int x, int y) {
+        x = std::min(x, width - 1);
+        y = std::min(y, height - 1);
+        return frame.pixels.data() + ((height - 1 - y) * size_t(width) + x) * 4;
+    };
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const uint8_t* p = pixelAt(x, y);
+            lumaPlane[y * size_t(width) + x] = uint8_t((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+        }
+    }
+    for (int y = 0; y < chromaHeight; ++y) {
+        for (int x = 0; x < chromaWidth; ++x) {
+            int r = 0, g = 0, b = 0;
+            for (int dy = 0; dy < 2; ++dy) {
+                for (int dx = 0; dx < 2; ++dx) {
+                    const uint8_t* p = pixelAt(x * 2 + dx, y * 2 + dy);
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                }
+            }
+            // Коэффициенты умножены на 256, сумма 4 пикселей — ещё на 4
+            int cb = (-43 * r - 85 * g + 128 * b + 512) >> 10;
+            int cr = (128 * r - 107 * g - 21 * b + 512) >> 10;
+            cbPlane[y * size_t(chromaWidth) + x] = uint8_t(std::min(std::max(cb + 128, 0), 255));
+            crPlane[y * size_t(chromaWidth) + x] = uint8_t(std::min(std::max(cr + 128, 0), 255));
+        }
+    }
+
+    return fwrite("FRAME\n", 1, 6, stream) == 6 && fwrite(planes.data(), 1, planes.size(), stream) == planes.size();
+}
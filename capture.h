@@ -0,0 +1,79 @@
+#pragma once
+
+// Запись кадров без остановки конвейера.
+// - glReadPixels пишет в один из N буферов PBO (асинхронно), за каждым — fence.
+// - Буфер читается процессором, только когда его fence уже сработал,
+//   то есть через несколько кадров; основной поток лишь копирует готовые пиксели.
+// - Кодирование и запись на диск — на отдельном потоке: последовательность PNG
+//   (frame_000000.png ...) или один поток Y4M, если путь оканчивается на .y4m.
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FrameCapture {
+public:
+    // path — каталог для PNG или файл .y4m; fps пишется в заголовок Y4M
+    bool start(const std::string& path, int frameWidth, int frameHeight, int fps, int ringDepth = 3);
+    // Остаток кольца дочитывается с ожиданием, очередь кодировщика дописывается
+    void finish();
+
+    // После отрисовки кадра, до window.display()
+    void capture(GLuint sourceFramebuffer);
+
+    bool active() const { return recording; }
+
+private:
+    struct ReadbackSlot {
+        GLuint buffer = 0;
+        GLsync fence = 0;
+        uint64_t frame = 0;
+    };
+
+    struct EncodedFrame {
+        uint64_t index;
+        std::vector<uint8_t> pixels;   // RGBA, строки снизу вверх (как отдаёт OpenGL)
+    };
+
+    bool recording = false;
+    bool y4m = false;
+    std::string outputPath;
+    int width = 0;
+    int height = 0;
+    int framesPerSecond = 60;
+
+    std::vector<ReadbackSlot> ring;
+    size_t head = 0;          // Следующий слот для glReadPixels
+    size_t inFlight = 0;      // Сколько слотов ждут fence
+    uint64_t frameCounter = 0;
+
+    // Статистика основного потока
+    double mainThreadMilliseconds = 0.0;
+    uint64_t ringStalls = 0;      // Пришлось ждать видеокарту
+    uint64_t encoderStalls = 0;   // Пришлось ждать кодировщик
+
+    // Кодировщик
+    std::thread encoder;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    // Кольцевая очередь фиксированного размера (std::deque выделял бы блоки на ходу)
+    std::vector<EncodedFrame> queue;
+    size_t queueHead = 0;
+    size_t queueSize = 0;
+    std::vector<std::vector<uint8_t>> freeBuffers;   // Переиспользуемые кадры, чтобы не выделять память
+    bool stopping = false;
+    FILE* stream = nullptr;
+    std::vector<uint8_t> encodeScratch;
+
+    bool collect(bool wait);
+    void encoderLoop();
+    bool writePng(const EncodedFrame& frame);
+    bool writeY4mFrame(const EncodedFrame& frame);
+};
@@ -0,0 +1,478 @@
+#pragma once
+
+// Архетипная ECS.
+// Сущности с одинаковым набором компонентов живут в одном архетипе,
+// а каждый компонент архетипа хранится в отдельном непрерывном массиве (SoA).
+// Системы проходят по массивам линейно, без указателей и виртуальных вызовов.
+// Структурные изменения во время обхода (спавн/удаление) копятся в CommandBuffer
+// и применяются одним вызовом flush() в конце кадра.
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace ecs {
+
+constexpr uint32_t MAX_COMPONENTS = 32;
+using Mask = uint32_t;
+
+struct Entity {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+constexpr Entity NULL_ENTITY = {UINT32_MAX, 0};
+
+// Размеры компонентов по идентификатору (общие для всех реестров)
+inline size_t* componentSizes() {
+    static size_t sizes[MAX_COMPONENTS] = {};
+    return sizes;
+}
+
+// Идентификаторы типов компонентов раздаются при первом обращении
+inline uint32_t registerComponentType(size_t size) {
+    static std::atomic<uint32_t> counter{0};
+    uint32_t id = counter++;
+    assert(id < MAX_COMPONENTS && "Слишком много типов компонентов");
+    componentSizes()[id] = size;
+    return id;
+}
+
+template <typename T>
+uint32_t componentId() {
+    static_assert(std::is_trivially_copyable<T>::value, "Компоненты перемещаются memcpy и должны быть тривиально копируемыми");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Выравнивание компонента больше, чем даёт аллокатор");
+    static const uint32_t id = registerComponentType(sizeof(T));
+    return id;
+}
+
+template <typename... Ts>
+Mask maskOf() {
+    return (Mask(0) | ... | (Mask(1) << componentId<Ts>()));
+}
+
+// Непрерывный массив компонентов одного типа
+struct Column {
+    uint32_t componentId = 0;
+    size_t elementSize = 0;
+    std::vector<unsigned char> bytes;
+
+    void* at(size_t row) { return bytes.data() + row * elementSize; }
+    const void* at(size_t row) const { return bytes.data() + row * elementSize; }
+};
+
+struct Archetype {
+    Mask mask = 0;
+    std::vector<Column> columns;
+    int8_t columnOf[MAX_COMPONENTS];
+    std::vector<Entity> entities;
+
+    size_t size() const { return entities.size(); }
+
+    void reserve(size_t count) {
+        entities.reserve(count);
+        for (auto& column : columns) {
+            column.bytes.reserve(count * column.elementSize);
+        }
+    }
+
+    template <typename T>
+    T* data() {
+        int8_t column = columnOf[componentId<T>()];
+        return column < 0 ? nullptr : reinterpret_cast<T*>(columns[column].bytes.data());
+    }
+};
+
+class Registry {
+public:
+    Registry() {
+        // Архетип 0 — пустой набор, в него попадает только что созданная сущность
+        archetypeByMask[0] = 0;
+        archetypes.push_back(makeArchetype(0));
+    }
+
+    void reserve(size_t entityCount) {
+        records.reserve(entityCount);
+        freeIndices.reserve(entityCount);
+        // Через пустой архетип проходит каждая новая сущность (в том числе из CommandBuffer::spawn)
+        archetypes[0].reserve(entityCount);
+    }
+
+    // Резерв места в архетипе с заданным набором компонентов (для массового спавна)
+    template <typename... Ts>
+    void reserveArchetype(size_t entityCount) {
+        archetypes[findOrCreateArchetype(maskOf<Ts...>())].reserve(entityCount);
+    }
+
+    Entity create() {
+        uint32_t index;
+        if (!freeIndices.empty()) {
+            index = freeIndices.back();
+            freeIndices.pop_back();
+        } else {
+            index = static_cast<uint32_t>(records.size());
+            records.push_back(Record());
+        }
+
+        Record& record = records[index];
+        record.alive = true;
+        Entity entity = {index, record.generation};
+
+        Archetype& empty = archetypes[0];
+        record.archetype = 0;
+        record.row = static_cast<uint32_t>(empty.size());
+        empty.entities.push_back(entity);
+        ++aliveCount;
+        return entity;
+    }
+
+    void destroy(Entity entity) {
+        assert(iterating == 0 && "Удаление во время обхода — используйте CommandBuffer");
+        if (!isAlive(entity)) {
+            return;
+        }
+        Record& record = records[entity.index];
+        removeRow(record.archetype, record.row);
+        record.alive = false;
+        ++record.generation;
+        freeIndices.push_back(entity.index);
+        --aliveCount;
+    }
+
+    bool isAlive(Entity entity) const {
+        return entity.index < records.size()
+            && records[entity.index].alive
+            && records[entity.index].generation == entity.generation;
+    }
+
+    size_t size() const { return aliveCount; }
+
+    template <typename T>
+    T& add(Entity entity, const T& value = T()) {
+        addRaw(entity, componentId<T>(), &value);
+        return get<T>(entity);
+    }
+
+    // Добавление компонента без знания типа (используется при применении команд)
+    void addRaw(Entity entity, uint32_t id, const void* value) {
+        assert(iterating == 0 && "Структурное изменение во время обхода — используйте CommandBuffer");
+        assert(isAlive(entity));
+        Record& record = records[entity.index];
+        Mask oldMask = archetypes[record.archetype].mask;
+
+        if (oldMask & (Mask(1) << id)) {
+            Archetype& archetype = archetypes[record.archetype];
+            Column& column = archetype.columns[archetype.columnOf[id]];
+            std::memcpy(column.at(record.row), value, column.elementSize);
+            return;
+        }
+
+        uint32_t target = findOrCreateArchetype(oldMask | (Mask(1) << id));
+        uint32_t row = moveRow(entity, target);
+        Archetype& archetype = archetypes[target];
+        Column& column = archetype.columns[archetype.columnOf[id]];
+        std::memcpy(column.at(row), value, column.elementSize);
+    }
+
+    // Перевод сущности сразу в архетип с дополнительными компонентами (новые обнулены).
+    // Так пачка компонентов добавляется одним переносом строки, без промежуточных архетипов
+    void addComponents(Entity entity, Mask components) {
+        assert(iterating == 0 && "Структурное изменение во время обхода — используйте CommandBuffer");
+        assert(isAlive(entity));
+        Record& record = records[entity.index];
+        Mask oldMask = archetypes[record.archetype].mask;
+        if ((oldMask | components) != oldMask) {
+            moveRow(entity, findOrCreateArchetype(oldMask | components));
+        }
+    }
+
+    template <typename T>
+    void remove(Entity entity) {
+        assert(iterating == 0 && "Структурное изменение во время обхода — используйте CommandBuffer");
+        assert(isAlive(entity));
+        Record& record = records[entity.index];
+        Mask oldMask = archetypes[record.archetype].mask;
+        Mask bit = Mask(1) << componentId<T>();
+        if (!(oldMask & bit)) {
+            return;
+        }
+        moveRow(entity, findOrCreateArchetype(oldMask & ~bit));
+    }
+
+    template <typename T>
+    bool has(Entity entity) const {
+        return isAlive(entity) && (archetypes[records[entity.index].archetype].mask & (Mask(1) << componentId<T>()));
+    }
+
+    template <typename T>
+    T& get(Entity entity) {
+        assert(has<T>(entity));
+        const Record& record = records[entity.index];
+        return archetypes[record.archetype].data<T>()[record.row];
+    }
+
+    template <typename T>
+    T* tryGet(Entity entity) {
+        return has<T>(entity) ? &get<T>(entity) : nullptr;
+    }
+
+    // Обход всех сущностей, у которых есть компоненты Ts...
+    // Функция принимает (Ts&...) или (Entity, Ts&...).
+    template <typename... Ts, typename Fn>
+    void each(Fn&& fn) {
+        static_assert(sizeof...(Ts) > 0, "Запрос без компонентов не поддерживается");
+        const std::vector<uint32_t>& matches = match(maskOf<Ts...>());
+
+        ++iterating;
+        for (uint32_t archetypeIndex : matches) {
+            Archetype& archetype = archetypes[archetypeIndex];
+            size_t count = archetype.size();
+            if (count == 0) {
+                continue;
+            }
+            const Entity* entities = archetype.entities.data();
+            auto columns = std::make_tuple(archetype.data<Ts>()...);
+
+            for (size_t i = 0; i < count; ++i) {
+                if constexpr (std::is_invocable<Fn, Entity, Ts&...>::value) {
+                    fn(entities[i], std::get<Ts*>(columns)[i]...);
+                } else {
+                    fn(std::get<Ts*>(columns)[i]...);
+                }
+            }
+        }
+        --iterating;
+    }
+
+    // Обход целыми массивами: fn(count, const Entity*, Ts*...).
+    // Удобно для систем, которым нужна векторизация или разбиение на потоки.
+    template <typename... Ts, typename Fn>
+    void eachChunk(Fn&& fn) {
+        const std::vector<uint32_t>& matches = match(maskOf<Ts...>());
+
+        ++iterating;
+        for (uint32_t archetypeIndex : matches) {
+            Archetype& archetype = archetypes[archetypeIndex];
+            if (archetype.size() > 0) {
+                fn(archetype.size(), archetype.entities.data(), archetype.data<Ts>()...);
+            }
+        }
+        --iterating;
+    }
+
+    template <typename... Ts>
+    size_t count() {
+        size_t total = 0;
+        for (uint32_t archetypeIndex : match(maskOf<Ts...>())) {
+            total += archetypes[archetypeIndex].size();
+        }
+        return total;
+    }
+
+    bool isIterating() const { return iterating > 0; }
+
+private:
+    struct Record {
+        uint32_t archetype = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+        bool alive = false;
+    };
+
+    struct QueryCache {
+        size_t archetypesSeen = 0;
+        std::vector<uint32_t> matches;
+    };
+
+    std::vector<Record> records;
+    std::vector<uint32_t> freeIndices;
+    std::vector<Archetype> archetypes;
+    std::unordered_map<Mask, uint32_t> archetypeByMask;
+    std::unordered_map<Mask, QueryCache> queries;
+    size_t aliveCount = 0;
+    int iterating = 0;
+
+    Archetype makeArchetype(Mask mask) {
+        Archetype archetype;
+        archetype.mask = mask;
+        std::memset(archetype.columnOf, -1, sizeof(archetype.columnOf));
+        for (uint32_t id = 0; id < MAX_COMPONENTS; ++id) {
+            if (mask & (Mask(1) << id)) {
+                archetype.columnOf[id] = static_cast<int8_t>(archetype.columns.size());
+                Column column;
+                column.componentId = id;
+                column.elementSize = componentSizes()[id];
+                archetype.columns.push_back(std::move(column));
+            }
+        }
+        return archetype;
+    }
+
+    uint32_t findOrCreateArchetype(Mask mask) {
+        auto found = archetypeByMask.find(mask);
+        if (found != archetypeByMask.end()) {
+            return found->second;
+        }
+        uint32_t index = static_cast<uint32_t>(archetypes.size());
+        archetypes.push_back(makeArchetype(mask));
+        archetypeByMask[mask] = index;
+        return index;
+    }
+
+    // Список архетипов под запрос пересчитывается только при появлении новых архетипов
+    const std::vector<uint32_t>& match(Mask required) {
+        QueryCache& cache = queries[required];
+        for (; cache.archetypesSeen < archetypes.size(); ++cache.archetypesSeen) {
+            if ((archetypes[cache.archetypesSeen].mask & required) == required) {
+                cache.matches.push_back(static_cast<uint32_t>(cache.archetypesSeen));
+            }
+        }
+        return cache.matches;
+    }
+
+    // Перенос строки в другой архетип, общие компоненты копируются
+    uint32_t moveRow(Entity entity, uint32_t target) {
+        Record& record = records[entity.index];
+        Archetype& from = archetypes[record.archetype];
+        Archetype& to = archetypes[target];
+        uint32_t newRow = static_cast<uint32_t>(to.size());
+
+        to.entities.push_back(entity);
+        for (auto& column : to.columns) {
+            column.bytes.resize(column.bytes.size() + column.elementSize);
+            int8_t source = from.columnOf[column.componentId];
+            if (source >= 0) {
+                std::memcpy(column.at(newRow), from.columns[source].at(record.row), column.elementSize);
+            } else {
+                std::memset(column.at(newRow), 0, column.elementSize);
+            }
+        }
+
+        removeRow(record.archetype, record.row);
+        record.archetype = target;
+        record.row = newRow;
+        return newRow;
+    }
+
+    // Удаление строки перестановкой последней на её место
+    void removeRow(uint32_t archetypeIndex, uint32_t row) {
+        Archetype& archetype = archetypes[archetypeIndex];
+        uint32_t last = static_cast<uint32_t>(archetype.size() - 1);
+        if (row != last) {
+            Entity moved = archetype.entities[last];
+            archetype.entities[row] = moved;
+            for (auto& column : archetype.columns) {
+                std::memcpy(column.at(row), column.at(last), column.elementSize);
+            }
+            records[moved.index].row = row;
+        }
+        archetype.entities.pop_back();
+        for (auto& column : archetype.columns) {
+            column.bytes.resize(column.bytes.size() - column.elementSize);
+        }
+    }
+};
+
+// Отложенные структурные изменения.
+// Данные компонентов пишутся в один байтовый поток, поэтому после прогрева
+// буферы не перевыделяются и спавн посреди кадра не трогает кучу.
+class CommandBuffer {
+public:
+    // Сущность создаётся сразу (чтобы на неё можно было сослаться),
+    // но компоненты появятся только после flush()
+    Entity spawn(Registry& registry) {
+        return registry.create();
+    }
+
+    template <typename T>
+    void add(Entity entity, const T& value) {
+        static_assert(sizeof(T) <= MAX_INLINE_COMPONENT, "Компонент слишком велик для CommandBuffer");
+        Header header = {entity, componentId<T>(), static_cast<uint32_t>(sizeof(T))};
+        size_t offset = stream.size();
+        stream.resize(offset + sizeof(Header) + sizeof(T));
+        std::memcpy(stream.data() + offset, &header, sizeof(Header));
+        std::memcpy(stream.data() + offset + sizeof(Header), &value, sizeof(T));
+    }
+
+    void despawn(Entity entity) {
+        despawns.push_back(entity);
+    }
+
+    bool empty() const { return stream.empty() && despawns.empty(); }
+
+    // Резерв под данные компонентов и удаления за кадр, чтобы не расти посреди игры
+    void reserve(size_t streamBytes, size_t despawnCount) {
+        stream.reserve(streamBytes);
+        despawns.reserve(despawnCount);
+    }
+
+    void flush(Registry& registry) {
+        assert(!registry.isIterating());
+
+        size_t offset = 0;
+        while (offset < stream.size()) {
+            // Команды одной сущности идут подряд: собираем их маску и переносим
+            // сущность сразу в итоговый архетип, дальше только копируем значения
+            Header first;
+            std::memcpy(&first, stream.data() + offset, sizeof(Header));
+            Mask mask = 0;
+            size_t end = offset;
+            while (end < stream.size()) {
+                Header header;
+                std::memcpy(&header, stream.data() + end, sizeof(Header));
+                if (header.entity != first.entity) {
+                    break;
+                }
+                mask |= Mask(1) << header.componentId;
+                end += sizeof(Header) + header.size;
+            }
+
+            // Сущность могли удалить раньше, чем до неё дошла очередь
+            bool alive = registry.isAlive(first.entity);
+            if (alive) {
+                registry.addComponents(first.entity, mask);
+            }
+            while (offset < end) {
+                Header header;
+                std::memcpy(&header, stream.data() + offset, sizeof(Header));
+                offset += sizeof(Header);
+                if (alive) {
+                    alignas(std::max_align_t) unsigned char value[MAX_INLINE_COMPONENT];
+                    assert(header.size <= sizeof(value));
+                    std::memcpy(value, stream.data() + offset, header.size);
+                    registry.addRaw(header.entity, header.componentId, value);
+                }
+                offset += header.size;
+            }
+        }
+        stream.clear();
+
+        for (Entity entity : despawns) {
+            registry.destroy(entity);
+        }
+        despawns.clear();
+    }
+
+private:
+    static constexpr size_t MAX_INLINE_COMPONENT = 256;
+
+    struct Header {
+        Entity entity;
+        uint32_t componentId;
+        uint32_t size;
+    };
+
+    std::vector<unsigned char> stream;
+    std::vector<Entity> despawns;
+};
+
+} // namespace ecs
@@ -17,6 +17,19 @@
 #include <cstdlib>
 #include <ctime>
 #include <string>
+#include <memory>
+#include <algorithm>
+
+#include "ecs.h"
+#include "planner.h"
+#include "particles.h"
+#include "textures.h"
+#include "capture.h"
+#include "memory.h"
+#include "simulation.h"
+#include "sky.h"
+#include "antialiasing.h"
+#include "postprocess.h"
 
 
 
@@ -25,36 +38,26 @@ struct Vertex {
     glm::vec3 position;
     glm::vec3 normal;
     glm::vec3 color;
+    glm::vec2 uv;
 };
 
 struct Model {
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    glm::vec3 baseColor;
     bool hasIndices;
-};
-
-struct Cloud {
-    glm::vec3 position;
-    glm::vec3 velocity;
-    float flashTimer;
-    float flashDuration;
-    bool isFlashing;
-    float oscillation;
-};
-
-struct Balloon {
-    glm::vec3 position;
-    glm::vec3 color;
-    float oscillation;
+    int texture = NO_TEXTURE;   // Дескриптор в textureStreamer
+    float textureTiles = 1.0f;  // Сколько раз текстура повторяется на модели
+    float radius = 0.0f;        // Радиус ограничивающей сферы (считается в uploadModel)
+
+    // Буферы на видеокарте (загружаются один раз в uploadModel)
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    GLuint EBO = 0;
 };
 
 // Глобальные переменные
 int width = 1200, height = 800;
 glm::mat4 projection, view;
-glm::vec3 airshipPos = glm::vec3(0.0f, 15.0f, 0.0f);
-float airshipYaw = 0.0f;
-float airshipSpeed = 15.0f;
 
 // ДОБАВЛЕНО: Режим камеры
 enum CameraMode {
@@ -66,14 +69,67 @@ CameraMode cameraMode = CAMERA_FOLLOW;
 // Шейдерные программы
 GLuint shaderProgram;
 GLuint cloudShaderProgram;
+GLint mainModelLoc = -1;
+GLint mainTintLoc = -1;
+GLint cloudModelLoc = -1;
+GLint cloudFlashLoc = -1;
 
 // Модели
-Model groundModel, treeModel, airshipModel, cloudModel, balloonModel;
-std::vector<Cloud> clouds;
-std::vector<Balloon> balloons;
-
-bool spotlightOn = false;
-float timeElapsed = 0.0f;
+std::vector<Model> models(MODEL_COUNT);
+
+// Сцена, автопилот и планировщик маршрутов (simulation.h)
+World world;
+
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 500.0f;
+const float GROUND_HEIGHT = 0.0f;
+const unsigned int RAIN_PARTICLES = 1u << 20;
+const float FIELD_OF_VIEW = 60.0f;
+const size_t TEXTURE_MEMORY_BUDGET = 64u << 20;   // Видеопамять под текстуры
+const size_t TEXTURE_UPLOAD_BUDGET = 2u << 20;    // Сколько байт текстур заливать за кадр
+const size_t FRAME_ARENA_SIZE = 1u << 20;         // Временная память кадра
+const int ALLOCATION_WARMUP_FRAMES = 120;         // После стольких кадров куча в цикле запрещена
+const size_t RENDER_TARGET_BUDGET = 16u << 20;    // Видеопамять под HDR-кадр и цепочку bloom
+
+// Частицы дождя
+ParticleSystem particles;
+
+// Небо, солнце и дымка на расстоянии
+SkyAtmosphere sky;
+float timeOfDay = 10.0f;                          // Часы, 0..24
+bool dayCycleRunning = true;
+const float DAY_CYCLE_HOURS_PER_SECOND = 24.0f / 480.0f;   // Сутки за 8 минут
+
+// Временная память кадра: списки, которые живут до следующего кадра
+FrameArena frameArena;
+int allocatingFrames = 0;   // Кадры после прогрева, которые обращались к куче
+
+TextureStreamer textureStreamer;
+
+// Параметры командной строки
+struct Options {
+    std::string recordPath;   // Каталог для PNG или файл .y4m; пусто — без записи
+    bool headless = false;    // Без окна на экране: рисуем в offscreen-цель с фиксированным шагом
+    int frames = 0;           // Сколько кадров отработать (0 — пока окно не закроют)
+    int fps = 60;
+    uint32_t seed = static_cast<uint32_t>(time(nullptr));
+    std::string scriptPath;   // Сценарий ввода вместо клавиатуры (см. InputScript)
+    float timeOfDay = -1.0f;  // Начальное время суток; меньше нуля — 10 часов
+    AntiAliasingMode antiAliasing = AA_MSAA;
+    int antiAliasingBenchmark = 0;   // Кадров на каждый режим сглаживания при замере; 0 — без замера
+    float exposure = 1.0f;
+};
+Options options;
+InputScript inputScript;
+
+FrameCapture frameCapture;
+AntiAliasing antiAliasing;
+PostProcess postProcess;
+GLuint outputFramebuffer = 0;  // Готовый кадр: 0 — окно, в безоконном режиме — offscreen-цель
+GLuint hdrFramebuffer = 0;     // HDR-кадр после сглаживания (из пула postProcess)
+GLuint sceneFramebuffer = 0;   // Куда рисуется сцена в этом кадре (выбирает antiAliasing)
+GLuint offscreenColor = 0;
+GLuint offscreenDepth = 0;
 
 // Прототипы функций
 Model createGroundModel();
@@ -81,46 +137,33 @@ Model createTreeModel();
 Model createAirshipModel();
 Model createCloudModel();
 Model createBalloonModel();
-void initClouds();
-void initBalloons();
+Model createTargetModel();
+Model createParcelModel();
+void uploadModel(Model& model);
+glm::mat4 modelMatrixOf(const Transform& transform);
+void beginMainPass();
+void beginCloudPass();
 void renderModel(const Model& model, const glm::mat4& modelMatrix, const glm::vec3& color);
-void renderCloud(const Cloud& cloud);
-void renderBalloon(const Balloon& balloon);
-void processInput(sf::Window& window, float deltaTime);
-void updateClouds(float deltaTime);
-void updateBalloons(float deltaTime);
+void renderCloud(const Transform& transform, const StormCloud& cloud);
+void renderScene();
+InputState processInput(sf::Window& window);
+void updateParticles(float deltaTime);
 GLuint createShaderProgram(const std::string& vertexSource, const std::string& fragmentSource);
 
 // ДОБАВЛЕНО: Функция обновления камеры
+// Камеры — узлы иерархии дирижабля игрока (AirshipRig)
+SceneGraph::NodeId cameraNode() {
+    const AirshipRig& rig = world.registry.get<AirshipRig>(world.playerAirship);
+    return cameraMode == CAMERA_FOLLOW ? rig.followCamera : rig.aimCamera;
+}
+
+glm::vec3 cameraPosition() {
+    return world.scene.worldPosition(cameraNode());
+}
+
 void updateCamera() {
-    switch (cameraMode) {
-        case CAMERA_FOLLOW: {
-            // Камера сзади сверху дирижабля (оригинальный режим)
-            glm::vec3 cameraPos = airshipPos + glm::vec3(0.0f, 2.0f, 0.0f); // Немного выше центра
-            glm::vec3 cameraTarget = cameraPos + glm::vec3(
-                sin(airshipYaw), 
-                0.0f, 
-                cos(airshipYaw)
-            );
-            view = glm::lookAt(cameraPos, cameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
-            break;
-        }
-        
-        case CAMERA_AIM: {
-            // Камера прицеливания снизу дирижабля
-            // Позиция камеры под дирижаблем, немного сзади
-            glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), airshipYaw, glm::vec3(0.0f, 1.0f, 0.0f));
-            glm::vec4 cameraOffset = rotationMatrix * glm::vec4(0.0f, -1.5f, -1.0f, 1.0f);
-            glm::vec3 cameraPos = airshipPos + glm::vec3(cameraOffset);
-            
-            // Направление взгляда - вниз и вперед по курсу дирижабля
-            glm::vec4 lookOffset = rotationMatrix * glm::vec4(0.0f, -0.8f, 1.0f, 0.0f);
-            glm::vec3 cameraTarget = cameraPos + glm::normalize(glm::vec3(lookOffset)) * 10.0f;
-            
-            view = glm::lookAt(cameraPos, cameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
-            break;
-        }
-    }
+    // Узел камеры смотрит вдоль своей оси -Z, поэтому вид — обратная мировая матрица
+    view = glm::inverse(world.scene.world(cameraNode()));
 }
 
 // Функция создания шейдерной программы
@@ -171,16 +214,25 @@ GLuint createShaderProgram(const std::string& vertexSource, const std::string& f
     return program;
 }
 
+// Вставляет функции воздушной перспективы (sky.h) перед main() фрагментного шейдера
+std::string withAerialPerspective(const std::string& fragmentSource) {
+    std::string source = fragmentSource;
+    source.insert(source.find("void main()"), aerialPerspectiveGlsl());
+    return source;
+}
+
 // Шейдеры
 std::string mainVertexShader = R"(
     #version 330 core
     layout(location = 0) in vec3 aPos;
     layout(location = 1) in vec3 aNormal;
     layout(location = 2) in vec3 aColor;
+    layout(location = 3) in vec2 aTexCoord;
 
     out vec3 FragPos;
     out vec3 Normal;
     out vec3 Color;
+    out vec2 TexCoord;
 
     uniform mat4 model;
     uniform mat4 view;
@@ -190,6 +242,7 @@ std::string mainVertexShader = R"(
         FragPos = vec3(model * vec4(aPos, 1.0));
         Normal = aNormal;
         Color = aColor;
+        TexCoord = aTexCoord;
         gl_Position = projection * view * model * vec4(aPos, 1.0);
     }
 )";
@@ -199,9 +252,12 @@ std::string mainFragmentShader = R"(
     in vec3 FragPos;
     in vec3 Normal;
     in vec3 Color;
+    in vec2 TexCoord;
 
     out vec4 FragColor;
 
+    uniform sampler2D diffuseMap;   // Пока текстура грузится — белая заглушка
+    uniform vec3 objectTint;        // Цвет объекта (Renderable); вершины задают только узор и оттенки
     uniform vec3 lightDir;
     uniform vec3 lightColor;
     uniform vec3 viewPos;
@@ -221,8 +277,8 @@ std::string mainFragmentShader = R"(
         float diff = max(dot(norm, lightDirection), 0.0);
         vec3 diffuse = diff * lightColor;
 
-        // Фоновое освещение
-        vec3 ambient = 0.2 * lightColor;
+        // Фоновое освещение — свет неба (ночью не темнее лунного)
+        vec3 ambient = skyAmbient();
 
         // Прожекторный источник света
         vec3 spotlightEffect = vec3(0.0);
@@ -261,8 +317,9 @@ std::string mainFragmentShader = R"(
         }
 
         // Финальный цвет
-        vec3 result = (ambient + diffuse + spotlightEffect) * Color;
-        FragColor = vec4(result, 1.0);
+        vec3 albedo = Color * objectTint * texture(diffuseMap, TexCoord).rgb;
+        vec3 result = (ambient + diffuse + spotlightEffect) * albedo;
+        FragColor = vec4(applyAerialPerspective(result, FragPos), 1.0);
     }
 )";
 
@@ -301,69 +358,72 @@ std::string cloudFragmentShader = R"(
     uniform float time;
     uniform bool isFlashing;
     uniform mat4 model;
+    uniform vec3 cloudLight;   // Днём белые, на закате розовые, ночью тёмные
+
+    const float FLASH_INTENSITY = 8.0;   // Вспышка ярче белого — её подхватывает bloom
 
     void main() {
         // Градиент: темнее снизу, светлее сверху
         vec3 worldPos = vec3(model * vec4(FragPos, 1.0));
         float gradient = clamp(worldPos.y * 0.1 + 0.7, 0.5, 1.0);
         
-        vec3 baseColor = vec3(0.6, 0.6, 0.65) * gradient;
+        vec3 baseColor = vec3(0.6, 0.6, 0.65) * gradient * cloudLight;
         
         // Мерцание
         if (isFlashing) {
             float flash = sin(time * 40.0) * 0.5 + 0.5;
-            baseColor = mix(baseColor, vec3(1.0, 1.0, 0.7), flash * 0.6);
+            baseColor += vec3(1.0, 1.0, 0.7) * flash * FLASH_INTENSITY;
         }
         
         // Немного прозрачности по краям
         float edge = 1.0 - smoothstep(0.0, 1.0, length(FragPos) / 3.0);
-        FragColor = vec4(baseColor, 0.85 - edge * 0.2);
+        FragColor = vec4(applyAerialPerspective(baseColor, FragPos), 0.85 - edge * 0.2);
     }
 )";
 
 // Создание моделей
 Model createGroundModel() {
     Model model;
-    model.baseColor = glm::vec3(0.2f, 0.6f, 0.3f);
     model.hasIndices = true;
 
     float groundSize = 100.0f;
+    float tiles = 20.0f;      // Сколько раз текстура травы повторяется по стороне поля
 
-    // Создаем простой квадрат для земли
+    // Создаем простой квадрат для земли (вершины белые: цвет задаёт Renderable)
     Vertex vertices[] = {
-        {{-groundSize, 0.0f, -groundSize}, {0.0f, 1.0f, 0.0f}, {0.2f, 0.6f, 0.3f}},
-        {{groundSize, 0.0f, -groundSize}, {0.0f, 1.0f, 0.0f}, {0.2f, 0.6f, 0.3f}},
-        {{groundSize, 0.0f, groundSize}, {0.0f, 1.0f, 0.0f}, {0.2f, 0.6f, 0.3f}},
-        {{-groundSize, 0.0f, groundSize}, {0.0f, 1.0f, 0.0f}, {0.2f, 0.6f, 0.3f}}
+        {{-groundSize, 0.0f, -groundSize}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, 0.0f}},
+        {{groundSize, 0.0f, -groundSize}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {tiles, 0.0f}},
+        {{groundSize, 0.0f, groundSize}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {tiles, tiles}},
+        {{-groundSize, 0.0f, groundSize}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, tiles}}
     };
 
     unsigned int indices[] = {0, 1, 2, 0, 2, 3};
 
     model.vertices = std::vector<Vertex>(vertices, vertices + 4);
     model.indices = std::vector<unsigned int>(indices, indices + 6);
+    model.textureTiles = tiles;
 
     return model;
 }
 
 Model createTreeModel() {
     Model model;
-    model.baseColor = glm::vec3(0.0f, 0.5f, 0.0f);
     model.hasIndices = true;
 
     // УВЕЛИЧЕННЫЕ РАЗМЕРЫ ЁЛКИ
     float height = 15.0f;     // Было 8.0f - увеличили высоту
     float base = 5.0f;        // Было 3.0f - увеличили основание
 
-    // Вершины для пирамиды (ёлки)
+    // Вершины для пирамиды (ёлки): у основания темнее, к макушке светлее — множители к цвету Renderable
     Vertex vertices[] = {
-        // Основание (больше)
-        {{-base, 0.0f, -base}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.3f, 0.0f}},
-        {{base, 0.0f, -base}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.3f, 0.0f}},
-        {{base, 0.0f, base}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.3f, 0.0f}},
-        {{-base, 0.0f, base}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.3f, 0.0f}},
+        // Основание (больше); u чередуется, чтобы каждая боковая грань получила полную ширину текстуры
+        {{-base, 0.0f, -base}, {0.0f, -1.0f, 0.0f}, {0.6f, 0.6f, 0.6f}, {0.0f, 0.0f}},
+        {{base, 0.0f, -base}, {0.0f, -1.0f, 0.0f}, {0.6f, 0.6f, 0.6f}, {1.0f, 0.0f}},
+        {{base, 0.0f, base}, {0.0f, -1.0f, 0.0f}, {0.6f, 0.6f, 0.6f}, {0.0f, 0.0f}},
+        {{-base, 0.0f, base}, {0.0f, -1.0f, 0.0f}, {0.6f, 0.6f, 0.6f}, {1.0f, 0.0f}},
 
         // Вершина (выше)
-        {{0.0f, height, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.7f, 0.0f}}
+        {{0.0f, height, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.4f, 1.4f, 1.4f}, {0.5f, 1.0f}}
     };
 
     // Индексы (остаются те же)
@@ -387,7 +447,6 @@ Model createTreeModel() {
 
 Model createAirshipModel() {
     Model model;
-    model.baseColor = glm::vec3(0.8f, 0.2f, 0.2f);
     model.hasIndices = true;
 
     // Простой эллипсоид для дирижабля
@@ -396,6 +455,8 @@ Model createAirshipModel() {
     float radiusZ = 6.0f;
     int slices = 16;
     int stacks = 8;
+    model.vertices.reserve((stacks + 1) * (slices + 1));
+    model.indices.reserve(stacks * slices * 6);
 
     for (int i = 0; i <= stacks; ++i) {
         float phi = (float)i / stacks * glm::pi<float>();
@@ -411,7 +472,8 @@ Model createAirshipModel() {
             );
 
             v.normal = glm::normalize(v.position);
-            v.color = glm::vec3(0.8f, 0.2f, 0.2f);
+            v.color = glm::vec3(1.0f);   // Цвет корпуса — из Renderable
+            v.uv = glm::vec2((float)j / slices, (float)i / stacks);
 
             model.vertices.push_back(v);
         }
@@ -438,13 +500,14 @@ Model createAirshipModel() {
 
 Model createCloudModel() {
     Model model;
-    model.baseColor = glm::vec3(0.7f, 0.7f, 0.7f);  // БЫЛО: (0.9f, 0.9f, 0.9f) - ТЕМНЕЕ
     model.hasIndices = true;
 
     // Простая сфера для тучи - УВЕЛИЧИМ РАДИУС
     float radius = 3.0f;  // БЫЛО: 2.0f - БОЛЬШЕ
     int slices = 12;      // БЫЛО: 8 - БОЛЬШЕ ДЕТАЛЕЙ
     int stacks = 12;      // БЫЛО: 8 - БОЛЬШЕ ДЕТАЛЕЙ
+    model.vertices.reserve((stacks + 1) * (slices + 1));
+    model.indices.reserve(stacks * slices * 6);
 
     for (int i = 0; i <= stacks; ++i) {
         float phi = (float)i / stacks * glm::pi<float>();
@@ -461,6 +524,7 @@ Model createCloudModel() {
 
             v.normal = glm::normalize(v.position);
             v.color = glm::vec3(0.7f, 0.7f, 0.7f);  // ТЕМНЫЙ СЕРЫЙ
+            v.uv = glm::vec2((float)j / slices, (float)i / stacks);
 
             model.vertices.push_back(v);
         }
@@ -487,13 +551,14 @@ Model createCloudModel() {
 
 Model createBalloonModel() {
     Model model;
-    model.baseColor = glm::vec3(1.0f, 0.0f, 0.0f);
     model.hasIndices = true;
 
     // Простая сфера для воздушного шара
     float radius = 1.5f;
     int slices = 12;
     int stacks = 12;
+    model.vertices.reserve((stacks + 1) * (slices + 1));
+    model.indices.reserve(stacks * slices * 6);
 
     for (int i = 0; i <= stacks; ++i) {
         float phi = (float)i / stacks * glm::pi<float>();
@@ -509,7 +574,8 @@ Model createBalloonModel() {
             );
 
             v.normal = glm::normalize(v.position);
-            v.color = glm::vec3(1.0f, 0.0f, 0.0f);
+            v.color = glm::vec3(1.0f);   // Цвет шара — из Renderable (у каждого свой)
+            v.uv = glm::vec2((float)j / slices, (float)i / stacks);
 
             model.vertices.push_back(v);
         }
@@ -534,56 +600,151 @@ Model createBalloonModel() {
     return model;
 }
 
-void initClouds() {
-    srand(time(nullptr));
+Model createTargetModel() {
+    Model model;
+    model.hasIndices = true;
+
+    // Плоская мишень: чередующиеся красные и белые кольца. Узор — в вершинах,
+    // поэтому основной цвет мишени белый (modelColor)
+    int rings = 4;
+    int slices = 24;
+    float ringWidth = 1.0f;
 
-    for (int i = 0; i < 8; ++i) {
-        Cloud cloud;
-        cloud.position = glm::vec3(
-            (rand() % 200 - 100),
-            30.0f + (rand() % 20),
-            (rand() % 200 - 100)
-        );
-        cloud.velocity = glm::vec3(
-            (rand() % 100 - 50) * 0.01f,
-            0.0f,
-            (rand() % 100 - 50) * 0.01f
-        );
-        cloud.flashTimer = 0.0f;
-        cloud.flashDuration = 2.0f + (rand() % 100) * 0.01f;
-        cloud.isFlashing = false;
-        cloud.oscillation = (rand() % 100) * 0.01f * glm::pi<float>();
+    model.vertices.reserve(rings * (slices + 1) * 2);
+    model.indices.reserve(rings * slices * 6);
 
-        clouds.push_back(cloud);
+    for (int r = 0; r < rings; ++r) {
+        glm::vec3 color = (r % 2 == 0) ? glm::vec3(0.9f, 0.1f, 0.1f) : glm::vec3(0.95f, 0.95f, 0.95f);
+        float inner = r * ringWidth;
+        float outer = inner + ringWidth;
+        unsigned int start = model.vertices.size();
+
+        for (int j = 0; j <= slices; ++j) {
+            float u = (float)j / slices;
+            float theta = u * 2.0f * glm::pi<float>();
+            glm::vec3 dir(cos(theta), 0.0f, sin(theta));
+
+            model.vertices.push_back({dir * inner + glm::vec3(0.0f, 0.05f, 0.0f), {0.0f, 1.0f, 0.0f}, color, {u, (float)r / rings}});
+            model.vertices.push_back({dir * outer + glm::vec3(0.0f, 0.05f, 0.0f), {0.0f, 1.0f, 0.0f}, color, {u, (float)(r + 1) / rings}});
+        }
+
+        for (int j = 0; j < slices; ++j) {
+            unsigned int first = start + j * 2;
+
+            model.indices.push_back(first);
+            model.indices.push_back(first + 2);
+            model.indices.push_back(first + 1);
+
+            model.indices.push_back(first + 1);
+            model.indices.push_back(first + 2);
+            model.indices.push_back(first + 3);
+        }
     }
+
+    return model;
 }
 
-void initBalloons() {
-    srand(time(nullptr));
+Model createParcelModel() {
+    Model model;
+    model.hasIndices = true;
 
-    for (int i = 0; i < 10; ++i) {
-        Balloon balloon;
-        balloon.position = glm::vec3(
-            (rand() % 180 - 90),
-            10.0f + (rand() % 20),
-            (rand() % 180 - 90)
-        );
-        balloon.color = glm::vec3(
-            (rand() % 100) * 0.01f,
-            (rand() % 100) * 0.01f,
-            (rand() % 100) * 0.01f
-        );
-        balloon.oscillation = 0.0f;
+    // Коробка-посылка: по 4 вершины на грань, чтобы нормали были плоскими
+    float s = 0.5f;
+    glm::vec3 normals[] = {
+        {1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f},
+        {0.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}
+    };
+    model.vertices.reserve(6 * 4);
+    model.indices.reserve(6 * 6);
+
+    for (const auto& n : normals) {
+        // Два касательных вектора грани
+        glm::vec3 u = (n.y != 0.0f) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 v = glm::cross(n, u);
+        unsigned int start = model.vertices.size();
+
+        model.vertices.push_back({(n - u - v) * s, n, glm::vec3(1.0f), {0.0f, 0.0f}});
+        model.vertices.push_back({(n + u - v) * s, n, glm::vec3(1.0f), {1.0f, 0.0f}});
+        model.vertices.push_back({(n + u + v) * s, n, glm::vec3(1.0f), {1.0f, 1.0f}});
+        model.vertices.push_back({(n - u + v) * s, n, glm::vec3(1.0f), {0.0f, 1.0f}});
+
+        model.indices.push_back(start);
+        model.indices.push_back(start + 1);
+        model.indices.push_back(start + 2);
+        model.indices.push_back(start);
+        model.indices.push_back(start + 2);
+        model.indices.push_back(start + 3);
+    }
 
-        balloons.push_back(balloon);
+    return model;
+}
+
+// Загрузка модели в видеопамять (один раз при старте, а не на каждый кадр)
+void uploadModel(Model& model) {
+    model.radius = 0.0f;
+    for (const auto& vertex : model.vertices) {
+        model.radius = std::max(model.radius, glm::length(vertex.position));
     }
+
+    glGenVertexArrays(1, &model.VAO);
+    glGenBuffers(1, &model.VBO);
+
+    glBindVertexArray(model.VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, model.VBO);
+    glBufferData(GL_ARRAY_BUFFER, model.vertices.size() * sizeof(Vertex), model.vertices.data(), GL_STATIC_DRAW);
+
+    // Позиция
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Нормаль
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(1);
+
+    // Цвет
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    glEnableVertexAttribArray(2);
+
+    // Текстурные координаты
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, uv));
+    glEnableVertexAttribArray(3);
+
+    if (model.hasIndices && !model.indices.empty()) {
+        glGenBuffers(1, &model.EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, model.indices.size() * sizeof(unsigned int), model.indices.data(), GL_STATIC_DRAW);
+    }
+
+    glBindVertexArray(0);
 }
 
-void renderModel(const Model& model, const glm::mat4& modelMatrix, const glm::vec3& color) {
+void deleteModel(Model& model) {
+    glDeleteVertexArrays(1, &model.VAO);
+    glDeleteBuffers(1, &model.VBO);
+    if (model.EBO) {
+        glDeleteBuffers(1, &model.EBO);
+    }
+}
+
+glm::mat4 modelMatrixOf(const Transform& transform) {
+    glm::mat4 modelMatrix = glm::mat4(1.0f);
+    modelMatrix = glm::translate(modelMatrix, transform.position);
+    modelMatrix = glm::rotate(modelMatrix, transform.yaw, glm::vec3(0.0f, 1.0f, 0.0f));
+    if (transform.pitch != 0.0f) {
+        modelMatrix = glm::rotate(modelMatrix, transform.pitch, glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+    if (transform.roll != 0.0f) {
+        modelMatrix = glm::rotate(modelMatrix, transform.roll, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+    return glm::scale(modelMatrix, transform.scale);
+}
+
+// Общие для всего кадра uniform-переменные основного шейдера
+void beginMainPass() {
     glUseProgram(shaderProgram);
 
-    // Установка uniform-переменных
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
     GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
     GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
     GLuint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
@@ -598,42 +759,31 @@ void renderModel(const Model& model, const glm::mat4& modelMatrix, const glm::ve
     GLuint spotlightCutoffLoc = glGetUniformLocation(shaderProgram, "spotlightCutoff");
     GLuint spotlightOuterCutoffLoc = glGetUniformLocation(shaderProgram, "spotlightOuterCutoff");
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
     glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
     glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform3f(lightDirLoc, -0.5f, -1.0f, -0.3f);
-    glUniform3f(lightColorLoc, 1.0f, 1.0f, 0.95f);
+    glActiveTexture(GL_TEXTURE0);
+    // Солнце из системы времени суток; его цвет — пропускание атмосферы на пути к камере
+    glm::vec3 sunColor = sky.sunColor() * glm::vec3(1.0f, 1.0f, 0.95f);
+    glUniform3fv(lightDirLoc, 1, glm::value_ptr(-sky.sunDirection()));
+    glUniform3fv(lightColorLoc, 1, glm::value_ptr(sunColor));
     
-    // Устанавливаем позицию камеры в зависимости от режима
-    glm::vec3 cameraPosForShaders;
-    if (cameraMode == CAMERA_FOLLOW) {
-        cameraPosForShaders = airshipPos + glm::vec3(0.0f, 2.0f, 0.0f);
-    } else {
-        // В режиме прицеливания - позиция камеры снизу дирижабля
-        glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), airshipYaw, glm::vec3(0.0f, 1.0f, 0.0f));
-        glm::vec4 cameraOffset = rotationMatrix * glm::vec4(0.0f, -1.5f, -1.0f, 1.0f);
-        cameraPosForShaders = airshipPos + glm::vec3(cameraOffset);
-    }
+    // Позиция камеры зависит от режима
+    glm::vec3 cameraPosForShaders = cameraPosition();
     glUniform3f(viewPosLoc, cameraPosForShaders.x, cameraPosForShaders.y, cameraPosForShaders.z);
+    sky.bindAerialPerspective(shaderProgram, cameraPosForShaders, 1, 2);
     
-    glUniform1i(spotlightLoc, spotlightOn ? 1 : 0);
+    // Шейдер поддерживает один прожектор — берём прожектор игрока
+    const AirshipRig& rig = world.registry.get<AirshipRig>(world.playerAirship);
+    const Light& light = world.registry.get<Light>(world.playerAirship);
+    glUniform1i(spotlightLoc, light.on ? 1 : 0);
     
-    // Параметры прожектора
-    // Позиция прожектора (под дирижаблем, немного сзади)
     glm::vec3 spotlightPosition;
     glm::vec3 spotlightDirection;
     
-    if (spotlightOn) {
-        // Матрица поворота дирижабля
-        glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), airshipYaw, glm::vec3(0.0f, 1.0f, 0.0f));
-        
-        // Смещение прожектора относительно дирижабля (вниз и сзади)
-        glm::vec4 offsetPos = rotationMatrix * glm::vec4(0.0f, -1.5f, -2.0f, 1.0f);
-        spotlightPosition = airshipPos + glm::vec3(offsetPos);
-        
-        // Направление прожектора (вниз и немного вперед)
-        glm::vec4 offsetDir = rotationMatrix * glm::vec4(0.0f, -1.0f, 0.2f, 0.0f);
-        spotlightDirection = glm::normalize(glm::vec3(offsetDir));
+    if (light.on) {
+        // Узел прожектора висит под дирижаблем (вниз и сзади) и смотрит вниз и немного вперёд
+        spotlightPosition = world.scene.worldPosition(rig.spotlight);
+        spotlightDirection = world.scene.worldForward(rig.spotlight);
     } else {
         // Если прожектор выключен, отправляем нулевые значения
         spotlightPosition = glm::vec3(0.0f);
@@ -642,114 +792,143 @@ void renderModel(const Model& model, const glm::mat4& modelMatrix, const glm::ve
     
     glUniform3f(spotlightPosLoc, spotlightPosition.x, spotlightPosition.y, spotlightPosition.z);
     glUniform3f(spotlightDirLoc, spotlightDirection.x, spotlightDirection.y, spotlightDirection.z);
-    glUniform3f(spotlightColorLoc, 1.0f, 1.0f, 0.9f); // Теплый белый свет
-    glUniform1f(spotlightCutoffLoc, cos(glm::radians(15.0f))); // Угол 15 градусов
-    glUniform1f(spotlightOuterCutoffLoc, cos(glm::radians(25.0f))); // Внешний угол 25 градусов
-
-    // Создание VBO и VAO
-    GLuint VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
+    glm::vec3 spotlightColor = light.color * light.intensity;
+    glUniform3f(spotlightColorLoc, spotlightColor.x, spotlightColor.y, spotlightColor.z);
+    glUniform1f(spotlightCutoffLoc, cos(glm::radians(light.cutoff)));
+    glUniform1f(spotlightOuterCutoffLoc, cos(glm::radians(light.outerCutoff)));
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, model.vertices.size() * sizeof(Vertex), model.vertices.data(), GL_STATIC_DRAW);
+void beginCloudPass() {
+    glUseProgram(cloudShaderProgram);
 
-    // Позиция
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
+    GLuint viewLoc = glGetUniformLocation(cloudShaderProgram, "view");
+    GLuint projLoc = glGetUniformLocation(cloudShaderProgram, "projection");
+    GLuint timeLoc = glGetUniformLocation(cloudShaderProgram, "time");
 
-    // Нормаль
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
+    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1f(timeLoc, world.timeElapsed);
+    glm::vec3 cloudLight = glm::vec3(0.25f) + 0.75f * sky.sunColor();
+    glUniform3fv(glGetUniformLocation(cloudShaderProgram, "cloudLight"), 1, glm::value_ptr(cloudLight));
+    sky.bindAerialPerspective(cloudShaderProgram, cameraPosition(), 1, 2);
 
-    // Цвет
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
-    glEnableVertexAttribArray(2);
+    glBindVertexArray(models[MODEL_CLOUD].VAO);
+}
 
+void drawModel(const Model& model) {
     if (model.hasIndices && !model.indices.empty()) {
-        glGenBuffers(1, &EBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, model.indices.size() * sizeof(unsigned int), model.indices.data(), GL_STATIC_DRAW);
-
         glDrawElements(GL_TRIANGLES, model.indices.size(), GL_UNSIGNED_INT, 0);
-
-        glDeleteBuffers(1, &EBO);
     } else {
         glDrawArrays(GL_TRIANGLES, 0, model.vertices.size());
     }
+}
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+void renderModel(const Model& model, const glm::mat4& modelMatrix, const glm::vec3& color) {
+    glUniformMatrix4fv(mainModelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+    glUniform3fv(mainTintLoc, 1, glm::value_ptr(color));
+    glBindTexture(GL_TEXTURE_2D, textureStreamer.texture(model.texture));
+    glBindVertexArray(model.VAO);
+    drawModel(model);
 }
 
-void renderCloud(const Cloud& cloud) {
-    glUseProgram(cloudShaderProgram);
+void renderCloud(const Transform& transform, const StormCloud& cloud) {
+    glm::mat4 modelMatrix = modelMatrixOf(transform);
 
-    glm::mat4 modelMatrix = glm::mat4(1.0f);
-    modelMatrix = glm::translate(modelMatrix, cloud.position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(3.0f, 2.0f, 3.0f));
+    glUniformMatrix4fv(cloudModelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+    glUniform1i(cloudFlashLoc, cloud.isFlashing ? 1 : 0);
 
-    // Установка uniform-переменных
-    GLuint modelLoc = glGetUniformLocation(cloudShaderProgram, "model");
-    GLuint viewLoc = glGetUniformLocation(cloudShaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(cloudShaderProgram, "projection");
-    GLuint timeLoc = glGetUniformLocation(cloudShaderProgram, "time");
-    GLuint flashLoc = glGetUniformLocation(cloudShaderProgram, "isFlashing");
+    drawModel(models[MODEL_CLOUD]);
+}
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform1f(timeLoc, timeElapsed);
-    glUniform1i(flashLoc, cloud.isFlashing ? 1 : 0);
+// Проверка ограничивающей сферы по плоскостям пирамиды видимости (Gribb, Hartmann)
+bool sphereInFrustum(const glm::mat4& viewProjection, const glm::vec3& center, float radius) {
+    for (int axis = 0; axis < 3; ++axis) {
+        for (float sign : {-1.0f, 1.0f}) {
+            glm::vec4 plane;
+            for (int column = 0; column < 4; ++column) {
+                plane[column] = viewProjection[column][3] + sign * viewProjection[column][axis];
+            }
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius * glm::length(glm::vec3(plane))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 
-    // Создание VBO и VAO для тучи
-    GLuint VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+// Сообщаем стримеру, сколько пикселей экрана занимает одно повторение текстуры модели.
+// Невидимые объекты не отмечаются — их текстуры со временем ужимаются
+void requestTextureDetail(const Model& model, const Transform& transform, const glm::mat4& viewProjection) {
+    if (model.texture == NO_TEXTURE) {
+        return;
+    }
 
-    glBindVertexArray(VAO);
+    float radius = model.radius * std::max(transform.scale.x, std::max(transform.scale.y, transform.scale.z));
+    if (!sphereInFrustum(viewProjection, transform.position, radius)) {
+        return;
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, cloudModel.vertices.size() * sizeof(Vertex), cloudModel.vertices.data(), GL_STATIC_DRAW);
+    float distance = std::max(glm::length(transform.position - cameraPosition()), 1.0f);
+    float screenSize = radius / (distance * tan(glm::radians(FIELD_OF_VIEW) * 0.5f)) * height;
+    textureStreamer.touch(model.texture, std::min(screenSize, 2.0f * height) / model.textureTiles);
+}
 
-    // Атрибуты
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
+void renderScene() {
+    glm::mat4 viewProjection = projection * view;
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
+    // Непрозрачные объекты: очередь отрисовки во временной памяти кадра,
+    // отсортированная по модели, чтобы реже переключать VAO и текстуры
+    struct DrawItem {
+        ModelId model;
+        glm::mat4 modelMatrix;
+        glm::vec3 color;
+    };
+    FrameVector<DrawItem> drawQueue(frameArena);
+    drawQueue.reserve(world.registry.count<Transform, Renderable>() + world.registry.count<AirshipRig>());
+    world.registry.each<Transform, Renderable>([&](ecs::Entity entity, const Transform& transform, const Renderable& renderable) {
+        if (renderable.material == MATERIAL_LIT) {
+            requestTextureDetail(models[renderable.model], transform, viewProjection);
+            // Дирижабли рисуются по узлу корпуса из иерархии, остальные — по Transform
+            const AirshipRig* rig = world.registry.tryGet<AirshipRig>(entity);
+            glm::mat4 modelMatrix = rig ? world.scene.world(rig->hull) : modelMatrixOf(transform);
+            drawQueue.push_back({renderable.model, modelMatrix, renderable.color});
+        }
+    });
+    // Груз под дирижаблями
+    world.registry.each<AirshipRig>([&](const AirshipRig& rig) {
+        drawQueue.push_back({MODEL_PARCEL, world.scene.world(rig.cargo), modelColor(MODEL_PARCEL)});
+    });
+    std::sort(drawQueue.begin(), drawQueue.end(), [](const DrawItem& a, const DrawItem& b) {
+        return a.model < b.model;
+    });
+
+    beginMainPass();
+    for (const DrawItem& item : drawQueue) {
+        renderModel(models[item.model], item.modelMatrix, item.color);
+    }
 
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
-    glEnableVertexAttribArray(2);
+    // Небо — там, куда не попал ни один непрозрачный объект
+    sky.render(view, projection);
 
-    if (cloudModel.hasIndices && !cloudModel.indices.empty()) {
-        glGenBuffers(1, &EBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, cloudModel.indices.size() * sizeof(unsigned int), cloudModel.indices.data(), GL_STATIC_DRAW);
+    // Глубина непрозрачной сцены нужна частицам для мягкого затухания у земли
+    particles.captureSceneDepth(sceneFramebuffer);
 
-        glDrawElements(GL_TRIANGLES, cloudModel.indices.size(), GL_UNSIGNED_INT, 0);
+    // Полупрозрачные тучи рисуются после непрозрачных, чтобы сквозь них было видно шары и дирижабли
+    beginCloudPass();
+    world.registry.each<Transform, StormCloud>([](const Transform& transform, const StormCloud& cloud) {
+        renderCloud(transform, cloud);
+    });
 
-        glDeleteBuffers(1, &EBO);
-    } else {
-        glDrawArrays(GL_TRIANGLES, 0, cloudModel.vertices.size());
-    }
+    glBindVertexArray(0);
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    // Дождь и искры
+    particles.render(view, projection, cameraPosition(), NEAR_PLANE, FAR_PLANE);
 }
 
-void renderBalloon(const Balloon& balloon) {
-    glm::mat4 modelMatrix = glm::mat4(1.0f);
-    glm::vec3 pos = balloon.position;
-    pos.y += sin(balloon.oscillation) * 0.5f; // Легкое покачивание
-    modelMatrix = glm::translate(modelMatrix, pos);
+// Клавиатура превращается в InputState, сам дирижабль двигает stepWorld
+InputState processInput(sf::Window& window) {
+    InputState input;
 
-    renderModel(balloonModel, modelMatrix, balloon.color);
-}
-
-void processInput(sf::Window& window, float deltaTime) {
     // Проверяем события
     while (auto event = window.pollEvent()) {
         if (event->is<sf::Event::Closed>()) {
@@ -762,8 +941,7 @@ void processInput(sf::Window& window, float deltaTime) {
             }
 
             if (keyEvent->scancode == sf::Keyboard::Scan::F) {
-                spotlightOn = !spotlightOn;
-                std::cout << "Прожектор: " << (spotlightOn ? "ВКЛ" : "ВЫКЛ") << std::endl;
+                input.toggleSpotlight = !input.toggleSpotlight;
             }
             
             // ДОБАВЛЕНО: Переключение режима камеры по клавише V
@@ -776,64 +954,190 @@ void processInput(sf::Window& window, float deltaTime) {
                     std::cout << "Режим камеры: СЛЕДОВАНИЕ (вид сзади)" << std::endl;
                 }
             }
+
+            if (keyEvent->scancode == sf::Keyboard::Scan::E) {
+                input.dropParcel = true;
+            }
+
+            if (keyEvent->scancode == sf::Keyboard::Scan::P) {
+                input.toggleAutopilot = !input.toggleAutopilot;
+            }
+
+            // Сглаживание: M — следующий режим
+            if (keyEvent->scancode == sf::Keyboard::Scan::M) {
+                antiAliasing.setMode(AntiAliasingMode((antiAliasing.mode() + 1) % AA_MODE_COUNT));
+                std::cout << "Сглаживание: " << antiAliasingName(antiAliasing.mode()) << std::endl;
+            }
+
+            // Время суток: T — остановить/запустить смену дня и ночи, [ и ] — на час назад/вперёд
+            if (keyEvent->scancode == sf::Keyboard::Scan::T) {
+                dayCycleRunning = !dayCycleRunning;
+                std::cout << "Смена дня и ночи: " << (dayCycleRunning ? "ИДЁТ" : "ОСТАНОВЛЕНА") << std::endl;
+            }
+            if (keyEvent->scancode == sf::Keyboard::Scan::LBracket || keyEvent->scancode == sf::Keyboard::Scan::RBracket) {
+                float shift = keyEvent->scancode == sf::Keyboard::Scan::LBracket ? -1.0f : 1.0f;
+                timeOfDay = std::fmod(timeOfDay + shift + 24.0f, 24.0f);
+                std::cout << "Время суток: " << int(timeOfDay) << " ч" << std::endl;
+            }
         }
     }
 
-    // Управление дирижаблем
+    // Управление дирижаблем игрока (под автопилотом игнорируется)
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::W))
-        airshipPos.z -= airshipSpeed * deltaTime;
+        input.move.z -= 1.0f;
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::S))
-        airshipPos.z += airshipSpeed * deltaTime;
+        input.move.z += 1.0f;
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::A))
-        airshipPos.x -= airshipSpeed * deltaTime;
+        input.move.x -= 1.0f;
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::D))
-        airshipPos.x += airshipSpeed * deltaTime;
+        input.move.x += 1.0f;
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Space))
-        airshipPos.y += airshipSpeed * deltaTime;
+        input.move.y += 1.0f;
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::LShift))
-        airshipPos.y -= airshipSpeed * deltaTime;
+        input.move.y -= 1.0f;
 
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Left))
-        airshipYaw += 1.5f * deltaTime;
+        input.turn += 1.0f;
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Right))
-        airshipYaw -= 1.5f * deltaTime;
+        input.turn -= 1.0f;
+
+    return input;
 }
 
-void updateClouds(float deltaTime) {
-    for (auto& cloud : clouds) {
-        // Движение по тригонометрической траектории
-        cloud.position.x += sin(timeElapsed + cloud.oscillation) * 0.5f * deltaTime;
-        cloud.position.z += cos(timeElapsed + cloud.oscillation) * 0.5f * deltaTime;
-        cloud.position.y += sin(timeElapsed * 0.7f + cloud.oscillation * 2.0f) * 0.2f * deltaTime;
+// Сообщения о том, что изменилось за шаг мира
+void reportStep(const InputState& input, int deliveriesBefore) {
+    if (input.toggleSpotlight) {
+        bool on = world.registry.get<Light>(world.playerAirship).on;
+        std::cout << "Прожектор: " << (on ? "ВКЛ" : "ВЫКЛ") << std::endl;
+    }
+    if (input.toggleAutopilot) {
+        bool active = world.registry.get<Autopilot>(world.playerAirship).active;
+        std::cout << "Автопилот: " << (active ? "ВКЛ" : "ВЫКЛ") << std::endl;
+    }
+    if (world.stats.deliveries != deliveriesBefore) {
+        std::cout << "Посылка доставлена! Всего: " << world.stats.deliveries << std::endl;
+    }
+}
 
-        cloud.oscillation += 0.1f * deltaTime;
+// Процессор только собирает параметры излучателей — частицы обновляет видеокарта
+void updateParticles(float deltaTime) {
+    FrameVector<ParticleEmitterParams> emitterParams(frameArena);
+    emitterParams.reserve(world.registry.count<Transform, Motion, StormCloud, RainEmitter>());
+    world.registry.each<Transform, Motion, StormCloud, RainEmitter>([&emitterParams](const Transform& transform, const Motion& motion, const StormCloud& cloud, const RainEmitter& emitter) {
+        emitterParams.push_back({transform.position, transform.scale * 3.0f, motion.velocity, cloud.isFlashing, emitter.sparkChance});
+    });
+    particles.update(emitterParams.data(), emitterParams.size(), deltaTime, world.timeElapsed, GROUND_HEIGHT);
+}
 
-        // Мерцание
-        cloud.flashTimer += deltaTime;
-        if (cloud.flashTimer >= cloud.flashDuration) {
-            cloud.isFlashing = true;
-            cloud.flashTimer = 0.0f;
-            cloud.flashDuration = 0.1f + (rand() % 100) * 0.001f;
-        } else if (cloud.isFlashing && cloud.flashTimer > 0.05f) {
-            cloud.isFlashing = false;
-            cloud.flashDuration = 3.0f + (rand() % 100) * 0.1f;
-        }
+// После прогрева кадр не должен трогать кучу: всё временное — в frameArena,
+// постоянное — заранее зарезервировано. Считаем только основной поток;
+// выделения внутри SFML и драйвера (через malloc) сюда не попадают
+void checkFrameAllocations(int frameIndex, const AllocationStats& frameStart) {
+    if (!allocationTrackingEnabled() || frameIndex < ALLOCATION_WARMUP_FRAMES) {
+        return;
+    }
+    AllocationStats frameEnd = threadAllocationStats();
+    uint64_t count = frameEnd.count - frameStart.count;
+    if (count == 0) {
+        return;
     }
+    if (++allocatingFrames <= 10) {
+        std::cerr << "Frame " << frameIndex << ": " << count << " heap allocations ("
+                  << frameEnd.bytes - frameStart.bytes << " bytes), last in '"
+                  << lastAllocationSection() << "'" << std::endl;
+    }
+}
+
+void printUsage(const char* program) {
+    std::cout << "Использование: " << program << " [--record <каталог|файл.y4m>] [--headless] [--frames N] [--fps N] [--seed N] [--script файл] [--time-of-day H]"
+              << " [--aa off|msaa|fxaa|taa] [--aa-benchmark N] [--exposure E]" << std::endl;
 }
 
-void updateBalloons(float deltaTime) {
-    for (auto& balloon : balloons) {
-        balloon.oscillation += deltaTime;
+bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--record" && hasValue) {
+            options.recordPath = argv[++i];
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--fps" && hasValue) {
+            options.fps = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--script" && hasValue) {
+            options.scriptPath = argv[++i];
+        } else if (arg == "--aa" && hasValue) {
+            if (!parseAntiAliasingMode(argv[++i], options.antiAliasing)) {
+                std::cerr << "Unknown anti-aliasing mode: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (arg == "--aa-benchmark" && hasValue) {
+            options.antiAliasingBenchmark = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--exposure" && hasValue) {
+            options.exposure = std::max(0.01f, float(atof(argv[++i])));
+        } else if (arg == "--time-of-day" && hasValue) {
+            options.timeOfDay = std::fmod(std::max(0.0f, float(atof(argv[++i]))), 24.0f);
+        } else {
+            std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    // Замер проходит все режимы сглаживания по очереди и завершается
+    if (options.antiAliasingBenchmark > 0 && options.frames == 0) {
+        options.frames = options.antiAliasingBenchmark * AA_MODE_COUNT;
     }
+    if (options.headless && options.frames == 0) {
+        std::cerr << "--headless requires --frames" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Offscreen-цель того же размера, что и окно: глубина в том же формате,
+// чтобы частицы могли скопировать её blit-ом
+bool createOffscreenTarget() {
+    glGenRenderbuffers(1, &offscreenColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &offscreenDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &outputFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreenDepth);
+
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
 }
 
-int main() {
+void deleteOffscreenTarget() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &outputFramebuffer);
+    glDeleteRenderbuffers(1, &offscreenColor);
+    glDeleteRenderbuffers(1, &offscreenDepth);
+    outputFramebuffer = 0;
+}
+
+int main(int argc, char** argv) {
 	setlocale(LC_ALL, "ru_RU.UTF-8");
+    if (!parseOptions(argc, argv)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
     // Настройки OpenGL
     sf::ContextSettings settings;
     settings.depthBits = 24;
     settings.stencilBits = 8;
-    settings.antiAliasingLevel = 4;
+    settings.antiAliasingLevel = 0;   // Сглаживание — своё (antialiasing.h), буфер окна без MSAA
     settings.majorVersion = 3;
     settings.minorVersion = 3;
 
@@ -843,7 +1147,9 @@ int main() {
                  sf::State::Windowed,
                  settings);
 
-    window.setVerticalSyncEnabled(true);
+    // В безоконном режиме окно нужно только ради контекста OpenGL
+    window.setVisible(!options.headless);
+    window.setVerticalSyncEnabled(!options.headless);
 	
 	glewExperimental = GL_TRUE;
 	if (glewInit() != GLEW_OK) {
@@ -866,85 +1172,213 @@ int main() {
     std::cout << "  Стрелки влево/вправо - поворот" << std::endl;
     std::cout << "  F - включить/выключить прожектор" << std::endl;
     std::cout << "  V - переключить режим камеры" << std::endl;  // ДОБАВЛЕНО
+    std::cout << "  E - сбросить посылку" << std::endl;
+    std::cout << "  P - включить/выключить автопилот" << std::endl;
+    std::cout << "  M - сменить режим сглаживания" << std::endl;
+    std::cout << "  T - остановить/запустить смену дня и ночи" << std::endl;
+    std::cout << "  [ / ] - час назад/вперёд" << std::endl;
     std::cout << "  ESC - выход" << std::endl;
 
     // Создание шейдеров
-    shaderProgram = createShaderProgram(mainVertexShader, mainFragmentShader);
-    cloudShaderProgram = createShaderProgram(cloudVertexShader, cloudFragmentShader);
+    shaderProgram = createShaderProgram(mainVertexShader, withAerialPerspective(mainFragmentShader));
+    cloudShaderProgram = createShaderProgram(cloudVertexShader, withAerialPerspective(cloudFragmentShader));
+    mainModelLoc = glGetUniformLocation(shaderProgram, "model");
+    mainTintLoc = glGetUniformLocation(shaderProgram, "objectTint");
+    cloudModelLoc = glGetUniformLocation(cloudShaderProgram, "model");
+    cloudFlashLoc = glGetUniformLocation(cloudShaderProgram, "isFlashing");
+    glUseProgram(shaderProgram);
+    glUniform1i(glGetUniformLocation(shaderProgram, "diffuseMap"), 0);
+    glUseProgram(0);
+
+    // Текстуры грузятся в фоне; пока их нет (или файлов нет вовсе) — белая заглушка
+    if (!textureStreamer.init(TEXTURE_MEMORY_BUDGET, TEXTURE_UPLOAD_BUDGET)) {
+        std::cerr << "Failed to initialize texture streamer" << std::endl;
+    }
 
     // Создание моделей
-    groundModel = createGroundModel();
-    treeModel = createTreeModel();
-    airshipModel = createAirshipModel();
-    cloudModel = createCloudModel();
-    balloonModel = createBalloonModel();
+    models[MODEL_GROUND] = createGroundModel();
+    models[MODEL_TREE] = createTreeModel();
+    models[MODEL_AIRSHIP] = createAirshipModel();
+    models[MODEL_CLOUD] = createCloudModel();
+    models[MODEL_BALLOON] = createBalloonModel();
+    models[MODEL_TARGET] = createTargetModel();
+    models[MODEL_PARCEL] = createParcelModel();
+    models[MODEL_GROUND].texture = textureStreamer.request("textures/grass.dds");
+    models[MODEL_TREE].texture = textureStreamer.request("textures/fir.dds");
+    models[MODEL_AIRSHIP].texture = textureStreamer.request("textures/airship.ktx2");
+    for (auto& model : models) {
+        uploadModel(model);
+    }
+
+    // Инициализация объектов. В безоконном режиме клавиатуру никто не трогает —
+    // дирижабль игрока летит на автопилоте или по сценарию
+    if (!options.scriptPath.empty()) {
+        std::string error;
+        if (!inputScript.load(options.scriptPath, error)) {
+            std::cerr << "Failed to load input script: " << error << std::endl;
+            return -1;
+        }
+    }
+    WorldSettings worldSettings;
+    worldSettings.seed = options.seed;
+    worldSettings.playerAutopilot = options.headless && options.scriptPath.empty();
+    initWorld(world, worldSettings);
+    frameArena.init(FRAME_ARENA_SIZE);
+
+    if (!particles.init(RAIN_PARTICLES, width, height)) {
+        std::cerr << "Failed to initialize particle system" << std::endl;
+    }
+
+    if (!antiAliasing.init(width, height, options.antiAliasing)) {
+        std::cerr << "Failed to initialize anti-aliasing targets" << std::endl;
+    }
+    if (!postProcess.init(width, height, RENDER_TARGET_BUDGET)) {
+        std::cerr << "Failed to initialize HDR pipeline" << std::endl;
+    }
+    postProcess.setExposure(options.exposure);
 
-    // Инициализация объектов
-    initClouds();
-    initBalloons();
+    if (!sky.init()) {
+        std::cerr << "Failed to initialize sky" << std::endl;
+    }
+    if (options.timeOfDay >= 0.0f) {
+        timeOfDay = options.timeOfDay;
+    }
+
+    if (options.headless) {
+        if (!createOffscreenTarget()) {
+            std::cerr << "Failed to create offscreen framebuffer" << std::endl;
+            return -1;
+        }
+    }
+    if (!options.recordPath.empty() && !frameCapture.start(options.recordPath, width, height, options.fps)) {
+        return -1;
+    }
 
     // Основной цикл
     sf::Clock clock;
     float lastFrame = 0.0f;
+    int frameIndex = 0;
 
     while (window.isOpen()) {
-        float currentFrame = clock.getElapsedTime().asSeconds();
-        float deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-        timeElapsed += deltaTime;
+        float deltaTime;
+        if (options.headless) {
+            // Фиксированный шаг: запись не зависит от скорости машины
+            deltaTime = 1.0f / options.fps;
+        } else {
+            float currentFrame = clock.getElapsedTime().asSeconds();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+        }
+        // Временные списки прошлого кадра больше не нужны
+        frameArena.reset();
+        AllocationStats frameStart = threadAllocationStats();
 
         // Обработка ввода
-        processInput(window, deltaTime);
+        setAllocationSection("ввод");
+        InputState input;
+        if (options.headless) {
+            while (window.pollEvent()) {
+            }
+        } else {
+            input = processInput(window);
+        }
+        // Сценарий заменяет управление дирижаблем; окно по-прежнему откликается на ESC и V
+        if (!inputScript.empty()) {
+            input = inputScript.next(world.timeElapsed + deltaTime);
+        }
+
+        // Обновление: автопилот, тучи, посылки, планировщик маршрутов
+        setAllocationSection("симуляция");
+        int deliveriesBefore = world.stats.deliveries;
+        stepWorld(world, input, deltaTime);
+        reportStep(input, deliveriesBefore);
+
+        setAllocationSection("частицы");
+        updateParticles(deltaTime);
+        setAllocationSection("текстуры");
+        textureStreamer.update(deltaTime);
+
+        // Время суток двигает солнце; таблицы неба пересчитываются, только когда оно сдвинулось заметно
+        setAllocationSection("небо");
+        if (dayCycleRunning) {
+            timeOfDay = std::fmod(timeOfDay + deltaTime * DAY_CYCLE_HOURS_PER_SECOND, 24.0f);
+        }
+        sky.update(sunDirectionAt(timeOfDay), cameraPosition().y);
 
-        // Обновление
-        updateClouds(deltaTime);
-        updateBalloons(deltaTime);
+        // Мировые матрицы всего, что сдвинулось за шаг, — одним проходом по иерархии
+        world.scene.update();
 
         // Очистка экрана
+        setAllocationSection("отрисовка");
+        if (options.antiAliasingBenchmark > 0 && frameIndex % options.antiAliasingBenchmark == 0) {
+            antiAliasing.setMode(AntiAliasingMode(frameIndex / options.antiAliasingBenchmark % AA_MODE_COUNT));
+        }
+        // Сцена — в HDR; сглаживание собирает кадр в hdrFramebuffer, postProcess выводит его в output
+        hdrFramebuffer = postProcess.beginFrame();
+        sceneFramebuffer = antiAliasing.beginFrame(hdrFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
         glClearColor(0.53f, 0.81f, 0.92f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Настройка проекции
-        projection = glm::perspective(glm::radians(60.0f), (float)width / (float)height, 0.1f, 500.0f);
+        // Настройка проекции (в режиме TAA — со сдвигом на субпиксель)
+        projection = glm::perspective(glm::radians(FIELD_OF_VIEW), (float)width / (float)height, NEAR_PLANE, FAR_PLANE);
+        projection = antiAliasing.jitter(projection);
 
         // ДОБАВЛЕНО: Обновление камеры (вызов новой функции)
         updateCamera();
 
-        // Рендеринг поля
-        glm::mat4 groundMatrix = glm::mat4(1.0f);
-        renderModel(groundModel, groundMatrix, groundModel.baseColor);
+        renderScene();
+        antiAliasing.resolve(view);
+        postProcess.finish(outputFramebuffer);
 
-        // Рендеринг ёлки
-        glm::mat4 treeMatrix = glm::mat4(1.0f);
-        treeMatrix = glm::translate(treeMatrix, glm::vec3(0.0f, 0.0f, 0.0f));
-        renderModel(treeModel, treeMatrix, treeModel.baseColor);
+        // Запись кадра (асинхронно, пиксели заберём через несколько кадров)
+        setAllocationSection("запись");
+        frameCapture.capture(outputFramebuffer);
 
-        // Рендеринг туч
-        for (const auto& cloud : clouds) {
-            renderCloud(cloud);
+        // Отображение
+        setAllocationSection("вывод");
+        if (!options.headless) {
+            window.display();
         }
+        setAllocationSection("вне кадра");
 
-        // Рендеринг воздушных шаров
-        for (const auto& balloon : balloons) {
-            renderBalloon(balloon);
-        }
+        checkFrameAllocations(frameIndex, frameStart);
 
-        // Рендеринг дирижабля
-        glm::mat4 airshipMatrix = glm::mat4(1.0f);
-        airshipMatrix = glm::translate(airshipMatrix, airshipPos);
-        airshipMatrix = glm::rotate(airshipMatrix, airshipYaw, glm::vec3(0.0f, 1.0f, 0.0f));
-        // Легкое покачивание
-        airshipMatrix = glm::rotate(airshipMatrix, float(sin(timeElapsed) * 0.02f), glm::vec3(1.0f, 0.0f, 0.0f));
-		airshipMatrix = glm::rotate(airshipMatrix, float(cos(timeElapsed * 1.3f) * 0.02f), glm::vec3(0.0f, 0.0f, 1.0f));
-        renderModel(airshipModel, airshipMatrix, airshipModel.baseColor);
+        ++frameIndex;
+        if (options.frames > 0 && frameIndex >= options.frames) {
+            window.close();
+        }
+    }
 
-        // Отображение
-        window.display();
+    if (allocationTrackingEnabled()) {
+        std::cout << "Heap allocations after warmup: " << allocatingFrames << " of "
+                  << std::max(frameIndex - ALLOCATION_WARMUP_FRAMES, 0) << " frames, frame arena peak "
+                  << frameArena.peak() << " of " << frameArena.capacity() << " bytes" << std::endl;
     }
 
+    antiAliasing.printCosts();
+    postProcess.printStats();
+
     // Очистка
+    frameCapture.finish();
+    if (options.headless) {
+        deleteOffscreenTarget();
+    }
+    world.routePlanner.reset();
+    particles.destroy();
+    sky.destroy();
+    antiAliasing.destroy();
+    postProcess.destroy();
+    textureStreamer.destroy();
+    for (auto& model : models) {
+        deleteModel(model);
+    }
     glDeleteProgram(shaderProgram);
     glDeleteProgram(cloudShaderProgram);
 
+    // В автономном режиме кадры с выделениями — ошибка: так прогон в CI ловит регрессии
+    if (options.headless && allocatingFrames > 0) {
+        return 2;
+    }
     return 0;
-}
\ No newline at end of file
+}
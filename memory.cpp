@@ -0,0 +1,130 @@
+#include "memory.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Тривиальные thread_local: доступны из operator new без динамической инициализации
+thread_local AllocationStats threadStats;
+thread_local const char* currentSection = "вне кадра";
+thread_local const char* lastSection = "нет";
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+#ifdef MAIL_AIRSHIP_TRACK_ALLOCATIONS
+
+// Выравненные варианты (std::align_val_t) не заменены и не считаются —
+// в проекте нет типов с выравниванием больше стандартного
+void* operator new(size_t size) {
+    ++threadStats.count;
+    threadStats.bytes += size;
+    lastSection = currentSection;
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+bool allocationTrackingEnabled() {
+    return true;
+}
+
+#else
+
+bool allocationTrackingEnabled() {
+    return false;
+}
+
+#endif
+
+AllocationStats threadAllocationStats() {
+    return threadStats;
+}
+
+void setAllocationSection(const char* name) {
+    currentSection = name;
+}
+
+const char* lastAllocationSection() {
+    return lastSection;
+}
+
+FrameArena::~FrameArena() {
+    for (unsigned char* extra : overflow) {
+        delete[] extra;
+    }
+    delete[] block;
+}
+
+void FrameArena::init(size_t capacity) {
+    delete[] block;
+    block = new unsigned char[capacity];
+    blockSize = capacity;
+    offset = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    size_t start = alignUp(offset, alignment);
+    if (start + size <= blockSize) {
+        offset = start + size;
+        peakUsed = std::max(peakUsed, used());
+        return block + start;
+    }
+
+    // Арена кончилась — кадр доживёт на куче, а к следующему кадру арена вырастет
+    unsigned char* extra = new unsigned char[size + alignment];
+    overflow.push_back(extra);
+    overflowBytes += size + alignment;
+    peakUsed = std::max(peakUsed, used());
+    return extra + alignUp(reinterpret_cast<uintptr_t>(extra), alignment) - reinterpret_cast<uintptr_t>(extra);
+}
+
+void FrameArena::reset() {
+    if (!overflow.empty()) {
+        for (unsigned char* extra : overflow) {
+            delete[] extra;
+        }
+        overflow.clear();
+        overflowBytes = 0;
+        init(std::max(blockSize * 2, peakUsed));
+    }
+    offset = 0;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+// Память без кучи в игровом цикле.
+// - FrameArena: линейный аллокатор на кадр. Выделение — сдвиг указателя,
+//   освобождение — reset() в начале следующего кадра. ArenaAllocator позволяет
+//   класть в арену std::vector (FrameVector) для временных списков кадра.
+// - Pool: объекты фиксированной ёмкости со стабильными индексами; память
+//   выделяется один раз при старте.
+// - Отладочный подсчёт выделений: при сборке с MAIL_AIRSHIP_TRACK_ALLOCATIONS
+//   глобальные operator new/delete считают выделения по потокам, а игровой цикл
+//   сообщает о каждом кадре, который после прогрева обратился к куче.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class FrameArena {
+public:
+    FrameArena() = default;
+    explicit FrameArena(size_t capacity) { init(capacity); }
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void init(size_t capacity);
+    void* allocate(size_t size, size_t alignment);
+    // Всё, что выделено с прошлого reset(), разом становится недействительным.
+    // Если арены не хватило, здесь же она вырастает до пикового расхода
+    void reset();
+
+    size_t used() const { return offset + overflowBytes; }
+    size_t capacity() const { return blockSize; }
+    size_t peak() const { return peakUsed; }
+
+private:
+    unsigned char* block = nullptr;
+    size_t blockSize = 0;
+    size_t offset = 0;
+    size_t peakUsed = 0;
+    size_t overflowBytes = 0;
+    std::vector<unsigned char*> overflow;   // Запасные блоки из кучи, когда арена переполнилась
+};
+
+// Аллокатор для контейнеров STL поверх FrameArena. deallocate ничего не делает,
+// поэтому растущие векторы лучше сразу резервировать на нужный размер
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(FrameArena& arena) noexcept : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) noexcept {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+    FrameArena* arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+// Пул объектов фиксированной ёмкости. Освобождённый объект не разрушается:
+// при повторной выдаче вызывающий сам приводит его в порядок, а вложенные
+// векторы сохраняют ёмкость
+template <typename T>
+class Pool {
+public:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    explicit Pool(size_t capacity) : items(capacity), used(capacity, 0) {
+        freeList.reserve(capacity);
+        for (size_t i = capacity; i > 0; --i) {
+            freeList.push_back(static_cast<uint32_t>(i - 1));
+        }
+    }
+
+    // INVALID, если пул исчерпан
+    uint32_t acquire() {
+        if (freeList.empty()) {
+            return INVALID;
+        }
+        uint32_t index = freeList.back();
+        freeList.pop_back();
+        used[index] = 1;
+        return index;
+    }
+
+    void release(uint32_t index) {
+        assert(index < items.size() && used[index]);
+        used[index] = 0;
+        freeList.push_back(index);
+    }
+
+    T& operator[](uint32_t index) {
+        assert(index < items.size() && used[index]);
+        return items[index];
+    }
+    const T& operator[](uint32_t index) const {
+        assert(index < items.size() && used[index]);
+        return items[index];
+    }
+
+    size_t size() const { return items.size() - freeList.size(); }
+    size_t capacity() const { return items.size(); }
+
+private:
+    std::vector<T> items;
+    std::vector<uint8_t> used;
+    std::vector<uint32_t> freeList;
+};
+
+struct AllocationStats {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+// false, если подсчёт не собран (тогда счётчики всегда нулевые)
+bool allocationTrackingEnabled();
+// Накопленные выделения текущего потока
+AllocationStats threadAllocationStats();
+// Имя участка кадра, которое запомнит следующее выделение в этом потоке
+void setAllocationSection(const char* name);
+// Где в этом потоке произошло последнее выделение
+const char* lastAllocationSection();
@@ -0,0 +1,464 @@
+#include "particles.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Обновление частиц: вершинный шейдер без растеризации, результат уходит
+// через transform feedback во второй буфер
+const char* particleUpdateShader = R"(
+    #version 330 core
+    layout(location = 0) in vec4 inPosition;   // xyz — позиция, w — оставшееся время жизни
+    layout(location = 1) in vec4 inVelocity;   // xyz — скорость, w — вид частицы
+
+    out vec4 outPosition;
+    out vec4 outVelocity;
+
+    const int MAX_EMITTERS = 32;
+    const float KIND_RAIN = 0.0;
+    const float KIND_SPARK = 1.0;
+    const float KIND_SPLASH = 2.0;
+
+    uniform vec4 emitterPos[MAX_EMITTERS];      // xyz — центр тучи, w — вспышка (0/1)
+    uniform vec4 emitterExtent[MAX_EMITTERS];   // xyz — полуоси тучи
+    uniform vec4 emitterVel[MAX_EMITTERS];      // xyz — дрейф тучи, w — доля искр во вспышке
+    uniform int emitterCount;
+    uniform float deltaTime;
+    uniform float time;
+    uniform float groundHeight;
+    uniform bool warmup;
+
+    uint seed;
+
+    // Целочисленный хеш -> [0, 1)
+    float random() {
+        seed = (seed ^ 61u) ^ (seed >> 16u);
+        seed *= 9u;
+        seed = seed ^ (seed >> 4u);
+        seed *= 0x27d4eb2du;
+        seed = seed ^ (seed >> 15u);
+        return float(seed & 0x00ffffffu) / 16777216.0;
+    }
+
+    vec3 randomDirection() {
+        float z = random() * 2.0 - 1.0;
+        float angle = random() * 6.2831853;
+        float r = sqrt(1.0 - z * z);
+        return vec3(r * cos(angle), z, r * sin(angle));
+    }
+
+    void main() {
+        vec3 position = inPosition.xyz;
+        float life = inPosition.w - deltaTime;
+        vec3 velocity = inVelocity.xyz;
+        float kind = inVelocity.w;
+
+        if (emitterCount == 0) {
+            outPosition = vec4(position, -1.0);
+            outVelocity = vec4(velocity, kind);
+            return;
+        }
+
+        // Частицы поровну закреплены за излучателями
+        int emitter = gl_VertexID % emitterCount;
+        vec3 center = emitterPos[emitter].xyz;
+        vec3 extent = emitterExtent[emitter].xyz;
+
+        if (life <= 0.0) {
+            seed = uint(gl_VertexID) * 1973u + uint(time * 1000.0) * 9277u + 26699u;
+            bool flashing = emitterPos[emitter].w > 0.5;
+
+            if (flashing && random() < emitterVel[emitter].w) {
+                // Искры разлетаются из тучи во время вспышки
+                position = center + randomDirection() * extent * 0.6;
+                velocity = randomDirection() * (6.0 + random() * 8.0);
+                life = 0.3 + random() * 0.4;
+                kind = KIND_SPARK;
+            } else {
+                // Капля появляется на нижней кромке тучи
+                float angle = random() * 6.2831853;
+                float radius = sqrt(random()) * 0.8;
+                position = center + vec3(cos(angle) * radius * extent.x, -extent.y * 0.5, sin(angle) * radius * extent.z);
+                if (warmup) {
+                    // При старте дождь уже идёт, а не начинается одной волной
+                    position.y = mix(groundHeight, position.y, random());
+                }
+                velocity = emitterVel[emitter].xyz + vec3(0.0, -(14.0 + random() * 4.0), 0.0);
+                life = (position.y - groundHeight) / -velocity.y + 0.1;
+                kind = KIND_RAIN;
+            }
+        } else {
+            if (kind == KIND_SPARK) {
+                velocity.y -= 4.9 * deltaTime;
+                velocity *= 1.0 - 1.5 * deltaTime;
+            }
+            position += velocity * deltaTime;
+
+            // Столкновение с землёй
+            if (position.y <= groundHeight) {
+                if (kind == KIND_RAIN) {
+                    position.y = groundHeight + 0.02;
+                    velocity = vec3(0.0, 1.5, 0.0);
+                    kind = KIND_SPLASH;
+                    life = 0.15;
+                } else if (kind == KIND_SPARK) {
+                    position.y = groundHeight;
+                    velocity.y = -velocity.y * 0.3;
+                    velocity.xz *= 0.6;
+                } else {
+                    life = 0.0;
+                }
+            }
+        }
+
+        outPosition = vec4(position, life);
+        outVelocity = vec4(velocity, kind);
+    }
+)";
+
+const char* particleUpdateFragmentShader = R"(
+    #version 330 core
+    out vec4 FragColor;
+    void main() {
+        FragColor = vec4(0.0);
+    }
+)";
+
+// Отрисовка: четырёхугольник на частицу, вытянутый вдоль скорости
+const char* particleVertexShader = R"(
+    #version 330 core
+    layout(location = 0) in vec2 aCorner;
+    layout(location = 1) in vec4 aPosition;
+    layout(location = 2) in vec4 aVelocity;
+
+    out vec2 Corner;
+    out vec4 Tint;
+    out float ViewDepth;
+
+    uniform mat4 view;
+    uniform mat4 projection;
+    uniform vec3 cameraPos;
+
+    void main() {
+        if (aPosition.w <= 0.0) {
+            // Мёртвая частица — выносим за пределы отсечения
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+            Corner = vec2(0.0);
+            Tint = vec4(0.0);
+            ViewDepth = 0.0;
+            return;
+        }
+
+        float kind = aVelocity.w;
+        vec3 axis = aVelocity.xyz;
+        float halfLength;
+        float halfWidth;
+
+        if (kind < 0.5) {
+            // Капля — тонкий штрих
+            halfLength = 0.35;
+            halfWidth = 0.015;
+            Tint = vec4(0.7, 0.75, 0.85, 0.35);
+        } else if (kind < 1.5) {
+            // Искра — яркая, гаснет к концу жизни
+            halfLength = 0.25;
+            halfWidth = 0.06;
+            Tint = vec4(1.0, 0.95, 0.6, min(aPosition.w * 3.0, 1.0));
+        } else {
+            // Брызги — маленький квадрат
+            axis = vec3(0.0, 1.0, 0.0);
+            halfLength = 0.08;
+            halfWidth = 0.08;
+            Tint = vec4(0.8, 0.85, 0.9, aPosition.w / 0.15 * 0.5);
+        }
+
+        vec3 toCamera = normalize(cameraPos - aPosition.xyz);
+        axis = length(axis) > 1e-4 ? normalize(axis) : vec3(0.0, 1.0, 0.0);
+        vec3 side = cross(axis, toCamera);
+        side = length(side) > 1e-4 ? normalize(side) : vec3(1.0, 0.0, 0.0);
+
+        vec3 world = aPosition.xyz + axis * aCorner.y * halfLength + side * aCorner.x * halfWidth;
+        vec4 viewPos = view * vec4(world, 1.0);
+
+        Corner = aCorner;
+        ViewDepth = -viewPos.z;
+        gl_Position = projection * viewPos;
+    }
+)";
+
+const char* particleFragmentShader = R"(
+    #version 330 core
+    in vec2 Corner;
+    in vec4 Tint;
+    in float ViewDepth;
+
+    out vec4 FragColor;
+
+    uniform sampler2D sceneDepth;
+    uniform vec2 viewport;
+    uniform vec2 planes;   // Ближняя и дальняя плоскости отсечения
+
+    float linearDepth(float depth) {
+        float z = depth * 2.0 - 1.0;
+        return 2.0 * planes.x * planes.y / (planes.y + planes.x - z * (planes.y - planes.x));
+    }
+
+    void main() {
+        // Мягкие частицы: гасим там, где частица почти касается геометрии
+        float scene = linearDepth(texture(sceneDepth, gl_FragCoord.xy / viewport).r);
+        float fade = clamp((scene - ViewDepth) / 0.5, 0.0, 1.0);
+        float edge = 1.0 - abs(Corner.x);
+        FragColor = vec4(Tint.rgb, Tint.a * fade * edge);
+    }
+)";
+
+GLuint compileShader(GLenum type, const char* source, const char* name) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+        std::cerr << name << " shader compilation failed:\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+// Сборка программы; для шейдера обновления перед линковкой задаются выходы transform feedback
+GLuint linkProgram(const char* vertexSource, const char* fragmentSource, bool captureFeedback) {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, "Particle vertex");
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, "Particle fragment");
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+
+    if (captureFeedback) {
+        const char* varyings[] = {"outPosition", "outVelocity"};
+        glTransformFeedbackVaryings(program, 2, varyings, GL_INTERLEAVED_ATTRIBS);
+    }
+    glLinkProgram(program);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
+        std::cerr << "Particle program linking failed:\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+// Частица: две vec4 подряд (позиция + жизнь, скорость + вид)
+const GLsizei PARTICLE_STRIDE = 8 * sizeof(float);
+
+} // namespace
+
+bool ParticleSystem::init(unsigned int maxParticles, int viewportWidth, int viewportHeight) {
+    particleCount = maxParticles;
+    width = viewportWidth;
+    height = viewportHeight;
+
+    updateProgram = linkProgram(particleUpdateShader, particleUpdateFragmentShader, true);
+    renderProgram = linkProgram(particleVertexShader, particleFragmentShader, false);
+
+    updateDeltaLoc = glGetUniformLocation(updateProgram, "deltaTime");
+    updateTimeLoc = glGetUniformLocation(updateProgram, "time");
+    updateGroundLoc = glGetUniformLocation(updateProgram, "groundHeight");
+    updateCountLoc = glGetUniformLocation(updateProgram, "emitterCount");
+    updateWarmupLoc = glGetUniformLocation(updateProgram, "warmup");
+    updateEmitterPosLoc = glGetUniformLocation(updateProgram, "emitterPos");
+    updateEmitterExtentLoc = glGetUniformLocation(updateProgram, "emitterExtent");
+    updateEmitterVelLoc = glGetUniformLocation(updateProgram, "emitterVel");
+
+    renderViewLoc = glGetUniformLocation(renderProgram, "view");
+    renderProjLoc = glGetUniformLocation(renderProgram, "projection");
+    renderCameraLoc = glGetUniformLocation(renderProgram, "cameraPos");
+    renderDepthLoc = glGetUniformLocation(renderProgram, "sceneDepth");
+    renderViewportLoc = glGetUniformLocation(renderProgram, "viewport");
+    renderPlanesLoc = glGetUniformLocation(renderProgram, "planes");
+
+    // Нулевое время жизни — все частицы родятся на первом обновлении
+    std::vector<float> zeros((size_t)particleCount * 8, 0.0f);
+
+    float corners[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+        -1.0f,  1.0f,
+         1.0f,  1.0f
+    };
+    glGenBuffers(1, &quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+    glGenBuffers(2, stateBuffers);
+    glGenVertexArrays(2, updateVAO);
+    glGenVertexArrays(2, renderVAO);
+    glGenTransformFeedbacks(2, feedback);
+
+    for (int i = 0; i < 2; ++i) {
+        glBindBuffer(GL_ARRAY_BUFFER, stateBuffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, zeros.size() * sizeof(float), zeros.data(), GL_DYNAMIC_COPY);
+
+        // Чтение состояния при обновлении
+        glBindVertexArray(updateVAO[i]);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, PARTICLE_STRIDE, (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, PARTICLE_STRIDE, (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        // Отрисовка: углы четырёхугольника + состояние частицы на инстанс
+        glBindVertexArray(renderVAO[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, stateBuffers[i]);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, PARTICLE_STRIDE, (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, PARTICLE_STRIDE, (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+
+        // Запись нового состояния
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedback[i]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, stateBuffers[i]);
+    }
+
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    createDepthTarget();
+    firstUpdate = true;
+    return glGetError() == GL_NO_ERROR;
+}
+
+void ParticleSystem::createDepthTarget() {
+    // Формат совпадает с буфером кадра окна (24 бита глубины + 8 трафарета),
+    // иначе glBlitFramebuffer не скопирует глубину
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &depthFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, depthFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Particle depth framebuffer is incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void ParticleSystem::resize(int viewportWidth, int viewportHeight) {
+    width = viewportWidth;
+    height = viewportHeight;
+    glDeleteFramebuffers(1, &depthFramebuffer);
+    glDeleteTextures(1, &depthTexture);
+    createDepthTarget();
+}
+
+void ParticleSystem::destroy() {
+    glDeleteProgram(updateProgram);
+    glDeleteProgram(renderProgram);
+    glDeleteBuffers(2, stateBuffers);
+    glDeleteBuffers(1, &quadBuffer);
+    glDeleteVertexArrays(2, updateVAO);
+    glDeleteVertexArrays(2, renderVAO);
+    glDeleteTransformFeedbacks(2, feedback);
+    glDeleteFramebuffers(1, &depthFramebuffer);
+    glDeleteTextures(1, &depthTexture);
+}
+
+void ParticleSystem::update(const ParticleEmitterParams* emitters, size_t count, float deltaTime, float time, float groundHeight) {
+    emitterCount = (int)std::min(count, (size_t)MAX_PARTICLE_EMITTERS);
+    for (int i = 0; i < emitterCount; ++i) {
+        const ParticleEmitterParams& emitter = emitters[i];
+        emitterPositions[i] = glm::vec4(emitter.position, emitter.flashing ? 1.0f : 0.0f);
+        emitterExtents[i] = glm::vec4(emitter.extent, 0.0f);
+        emitterVelocities[i] = glm::vec4(emitter.velocity, emitter.sparkChance);
+    }
+
+    glUseProgram(updateProgram);
+    glUniform1f(updateDeltaLoc, deltaTime);
+    glUniform1f(updateTimeLoc, time);
+    glUniform1f(updateGroundLoc, groundHeight);
+    glUniform1i(updateCountLoc, emitterCount);
+    glUniform1i(updateWarmupLoc, firstUpdate ? 1 : 0);
+    if (emitterCount > 0) {
+        glUniform4fv(updateEmitterPosLoc, emitterCount, glm::value_ptr(emitterPositions[0]));
+        glUniform4fv(updateEmitterExtentLoc, emitterCount, glm::value_ptr(emitterExtents[0]));
+        glUniform4fv(updateEmitterVelLoc, emitterCount, glm::value_ptr(emitterVelocities[0]));
+    }
+
+    int next = 1 - current;
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(updateVAO[current]);
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedback[next]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, particleCount);
+    glEndTransformFeedback();
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(0);
+
+    current = next;
+    firstUpdate = false;
+}
+
+void ParticleSystem::captureSceneDepth(GLuint sourceFramebuffer) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sourceFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depthFramebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, sourceFramebuffer);
+}
+
+void ParticleSystem::render(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos,
+                            float nearPlane, float farPlane) {
+    if (emitterCount == 0) {
+        return;
+    }
+
+    glUseProgram(renderProgram);
+    glUniformMatrix4fv(renderViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(renderProjLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3f(renderCameraLoc, cameraPos.x, cameraPos.y, cameraPos.z);
+    glUniform2f(renderViewportLoc, (float)width, (float)height);
+    glUniform2f(renderPlanesLoc, nearPlane, farPlane);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glUniform1i(renderDepthLoc, 0);
+
+    // Аддитивное смешивание без записи глубины: порядок частиц не важен
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+    glBindVertexArray(renderVAO[current]);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, particleCount);
+    glBindVertexArray(0);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_CULL_FACE);
+    glDepthMask(GL_TRUE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// GPU-система частиц для дождя и молний под грозовыми тучами.
+// Состояние частиц живёт только в видеопамяти: два буфера меняются ролями
+// каждый кадр, а обновление идёт вершинным шейдером через transform feedback.
+// Процессор передаёт лишь параметры излучателей (по одному на тучу).
+// Частицы рисуются инстансингом — по четырёхугольнику на частицу — с мягким
+// затуханием у поверхностей по буферу глубины сцены.
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+const int MAX_PARTICLE_EMITTERS = 32;
+
+struct ParticleEmitterParams {
+    glm::vec3 position;   // Центр тучи
+    glm::vec3 extent;     // Полуоси тучи
+    glm::vec3 velocity;   // Дрейф тучи — капли наследуют его как ветер
+    bool flashing;        // Во время вспышки туча сыплет искрами
+    float sparkChance;    // Доля новых частиц, которые во вспышке становятся искрами
+};
+
+class ParticleSystem {
+public:
+    bool init(unsigned int maxParticles, int viewportWidth, int viewportHeight);
+    void destroy();
+    void resize(int viewportWidth, int viewportHeight);
+
+    // Излучатели передаются массивом — список собирается во временной памяти кадра
+    void update(const ParticleEmitterParams* emitters, size_t count, float deltaTime, float time, float groundHeight);
+
+    // Глубина сцены копируется из текущего буфера кадра — вызывать после непрозрачных объектов
+    void captureSceneDepth(GLuint sourceFramebuffer);
+    void render(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos,
+                float nearPlane, float farPlane);
+
+    unsigned int size() const { return particleCount; }
+
+private:
+    unsigned int particleCount = 0;
+    int width = 0;
+    int height = 0;
+    int emitterCount = 0;
+    bool firstUpdate = true;
+
+    // Два набора буферов состояния: читаем из current, пишем в 1 - current
+    GLuint stateBuffers[2] = {0, 0};
+    GLuint updateVAO[2] = {0, 0};
+    GLuint renderVAO[2] = {0, 0};
+    GLuint feedback[2] = {0, 0};
+    int current = 0;
+
+    GLuint quadBuffer = 0;
+    GLuint updateProgram = 0;
+    GLuint renderProgram = 0;
+
+    GLuint depthFramebuffer = 0;
+    GLuint depthTexture = 0;
+
+    // Кэш размещений uniform-переменных
+    GLint updateDeltaLoc = -1;
+    GLint updateTimeLoc = -1;
+    GLint updateGroundLoc = -1;
+    GLint updateCountLoc = -1;
+    GLint updateWarmupLoc = -1;
+    GLint updateEmitterPosLoc = -1;
+    GLint updateEmitterExtentLoc = -1;
+    GLint updateEmitterVelLoc = -1;
+    GLint renderViewLoc = -1;
+    GLint renderProjLoc = -1;
+    GLint renderCameraLoc = -1;
+    GLint renderDepthLoc = -1;
+    GLint renderViewportLoc = -1;
+    GLint renderPlanesLoc = -1;
+
+    // Параметры излучателей в формате uniform-массивов
+    glm::vec4 emitterPositions[MAX_PARTICLE_EMITTERS];
+    glm::vec4 emitterExtents[MAX_PARTICLE_EMITTERS];
+    glm::vec4 emitterVelocities[MAX_PARTICLE_EMITTERS];
+
+    void createDepthTarget();
+};
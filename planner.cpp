@@ -0,0 +1,781 @@
+#include "planner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace planner {
+
+namespace {
+
+const float INF = std::numeric_limits<float>::infinity();
+
+using Clock = std::chrono::steady_clock;
+
+float millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+float horizontalDistance(const glm::vec3& a, const glm::vec3& b) {
+    float dx = a.x - b.x;
+    float dz = a.z - b.z;
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Сетка занятости
+// ---------------------------------------------------------------------------
+
+void OccupancyGrid::resize(const GridSettings& settings) {
+    origin = settings.minCorner;
+    cellSize = settings.cellSize;
+    glm::vec3 extent = (settings.maxCorner - settings.minCorner) / cellSize;
+    dims = glm::ivec3(
+        std::max(1, (int)std::ceil(extent.x)),
+        std::max(1, (int)std::ceil(extent.y)),
+        std::max(1, (int)std::ceil(extent.z))
+    );
+    cells.assign((size_t)dims.x * dims.y * dims.z, 0);
+}
+
+void OccupancyGrid::clear() {
+    std::fill(cells.begin(), cells.end(), 0);
+}
+
+bool OccupancyGrid::inside(const glm::ivec3& cell) const {
+    return cell.x >= 0 && cell.y >= 0 && cell.z >= 0
+        && cell.x < dims.x && cell.y < dims.y && cell.z < dims.z;
+}
+
+glm::ivec3 OccupancyGrid::cellOf(int index) const {
+    int x = index % dims.x;
+    int rest = index / dims.x;
+    return glm::ivec3(x, rest / dims.z, rest % dims.z);
+}
+
+glm::ivec3 OccupancyGrid::cellAt(const glm::vec3& position) const {
+    glm::vec3 local = (position - origin) / cellSize;
+    glm::ivec3 cell((int)std::floor(local.x), (int)std::floor(local.y), (int)std::floor(local.z));
+    return glm::clamp(cell, glm::ivec3(0), dims - glm::ivec3(1));
+}
+
+glm::vec3 OccupancyGrid::centerOf(const glm::ivec3& cell) const {
+    return origin + (glm::vec3(cell) + glm::vec3(0.5f)) * cellSize;
+}
+
+// Эллипсоид отмечается в нескольких точках предсказанной траектории,
+// так что в сетку попадает весь объём, который туча заметёт за horizon секунд
+void OccupancyGrid::markObstacle(const Obstacle& obstacle, float horizon, float margin) {
+    glm::vec3 radii = obstacle.extent + glm::vec3(margin);
+    float travel = glm::length(obstacle.velocity) * horizon;
+    int samples = 1 + (int)std::ceil(travel / cellSize);
+
+    for (int s = 0; s <= samples; ++s) {
+        float t = horizon * s / samples;
+        glm::vec3 center = obstacle.position + obstacle.velocity * t;
+        glm::ivec3 lo = cellAt(center - radii);
+        glm::ivec3 hi = cellAt(center + radii);
+
+        for (int y = lo.y; y <= hi.y; ++y) {
+            for (int z = lo.z; z <= hi.z; ++z) {
+                for (int x = lo.x; x <= hi.x; ++x) {
+                    glm::vec3 d = (centerOf(glm::ivec3(x, y, z)) - center) / radii;
+                    if (glm::dot(d, d) <= 1.0f) {
+                        cells[index(glm::ivec3(x, y, z))] = 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool OccupancyGrid::segmentFree(const glm::vec3& from, const glm::vec3& to) const {
+    float length = glm::length(to - from);
+    int steps = std::max(1, (int)std::ceil(length / (cellSize * 0.5f)));
+    for (int i = 0; i <= steps; ++i) {
+        glm::vec3 p = from + (to - from) * ((float)i / steps);
+        if (blocked(index(cellAt(p)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OccupancyGrid::diff(const OccupancyGrid& previous, std::vector<int>& changed) const {
+    changed.clear();
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (cells[i] != previous.cells[i]) {
+            changed.push_back((int)i);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// D* Lite
+// ---------------------------------------------------------------------------
+
+template <typename Fn>
+void DStarLite::forEachNeighbor(int node, Fn&& fn) const {
+    // Цена шага: 1 по грани, sqrt(2) по ребру, sqrt(3) по диагонали куба
+    static const float stepCost[4] = {0.0f, 1.0f, 1.41421356f, 1.73205081f};
+    glm::ivec3 cell = grid->cellOf(node);
+    const glm::ivec3& dims = grid->size();
+
+    for (int dy = -1; dy <= 1; ++dy) {
+        int y = cell.y + dy;
+        if (y < 0 || y >= dims.y) {
+            continue;
+        }
+        for (int dz = -1; dz <= 1; ++dz) {
+            int z = cell.z + dz;
+            if (z < 0 || z >= dims.z) {
+                continue;
+            }
+            for (int dx = -1; dx <= 1; ++dx) {
+                int x = cell.x + dx;
+                int axes = (dx != 0) + (dy != 0) + (dz != 0);
+                if (axes == 0 || x < 0 || x >= dims.x) {
+                    continue;
+                }
+                fn((y * dims.z + z) * dims.x + x, stepCost[axes]);
+            }
+        }
+    }
+}
+
+// Октильная эвристика для 26-связной сетки: точна в пустом пространстве
+// и согласована с ценами шагов, поэтому раскрывается минимум ячеек
+float DStarLite::heuristic(int a, int b) const {
+    glm::ivec3 d = glm::abs(grid->cellOf(a) - grid->cellOf(b));
+    int hi = std::max(d.x, std::max(d.y, d.z));
+    int lo = std::min(d.x, std::min(d.y, d.z));
+    int mid = d.x + d.y + d.z - hi - lo;
+    return hi + 0.41421356f * mid + 0.31783725f * lo;
+}
+
+bool DStarLite::passable(int node) const {
+    // Старт и цель считаем свободными, даже если туча уже рядом
+    return !grid->blocked(node) || node == startIndex || node == goalIndex;
+}
+
+DStarLite::Key DStarLite::calculateKey(int node) const {
+    float best = std::min(g[node], rhs[node]);
+    return {best + heuristic(startIndex, node) + km, best};
+}
+
+void DStarLite::push(int node) {
+    Key key = calculateKey(node);
+    openKey[node] = key;
+    inOpen[node] = 1;
+    open.push_back({key, node});
+    std::push_heap(open.begin(), open.end(), [](const OpenEntry& a, const OpenEntry& b) { return b.key < a.key; });
+}
+
+DStarLite::OpenEntry DStarLite::pop() {
+    std::pop_heap(open.begin(), open.end(), [](const OpenEntry& a, const OpenEntry& b) { return b.key < a.key; });
+    OpenEntry entry = open.back();
+    open.pop_back();
+    return entry;
+}
+
+// Полный пересчёт rhs как минимума по соседям
+float DStarLite::bestNeighbor(int node) const {
+    if (!passable(node)) {
+        return INF;
+    }
+    float best = INF;
+    forEachNeighbor(node, [&](int next, float step) {
+        if (passable(next)) {
+            best = std::min(best, step + g[next]);
+        }
+    });
+    return best;
+}
+
+void DStarLite::updateMembership(int node) {
+    if (g[node] != rhs[node]) {
+        push(node);
+    } else {
+        inOpen[node] = 0;
+    }
+}
+
+void DStarLite::reset(const OccupancyGrid* newGrid, const glm::ivec3& start, const glm::ivec3& goal) {
+    grid = newGrid;
+    startCell = start;
+    goalCell = goal;
+    startIndex = grid->index(start);
+    goalIndex = grid->index(goal);
+    lastStart = startIndex;
+    km = 0.0f;
+
+    size_t count = grid->cellCount();
+    g.assign(count, INF);
+    rhs.assign(count, INF);
+    openKey.assign(count, Key{INF, INF});
+    inOpen.assign(count, 0);
+    open.clear();
+
+    rhs[goalIndex] = 0.0f;
+    push(goalIndex);
+}
+
+void DStarLite::attach(const OccupancyGrid* newGrid) {
+    grid = newGrid;
+}
+
+void DStarLite::moveStart(const glm::ivec3& start) {
+    if (start == startCell) {
+        return;
+    }
+    int oldIndex = startIndex;
+    startCell = start;
+    startIndex = grid->index(start);
+    km += heuristic(lastStart, startIndex);
+    lastStart = startIndex;
+
+    // Старт считается свободным, поэтому у занятых ячеек на старом и новом
+    // месте старта меняется цена рёбер
+    touched.clear();
+    if (grid->blocked(oldIndex)) {
+        touched.push_back(oldIndex);
+    }
+    if (grid->blocked(startIndex)) {
+        touched.push_back(startIndex);
+    }
+    cellsChanged(touched);
+}
+
+// У ячейки с изменившейся занятостью меняется цена всех рёбер, поэтому
+// пересчитываем rhs у неё самой и у всех соседей
+void DStarLite::cellsChanged(const std::vector<int>& changed) {
+    auto refresh = [&](int node) {
+        if (node != goalIndex) {
+            rhs[node] = bestNeighbor(node);
+        }
+        updateMembership(node);
+    };
+    for (int node : changed) {
+        refresh(node);
+        forEachNeighbor(node, [&](int next, float) { refresh(next); });
+    }
+}
+
+// Оптимизированный вариант из статьи: при уменьшении g соседям достаточно
+// сравнить rhs с путём через узел, полный пересчёт нужен только при росте g
+bool DStarLite::computeShortestPath(int maxExpansions) {
+    int expansions = 0;
+
+    while (!open.empty()) {
+        const OpenEntry& top = open.front();
+        // Устаревшие записи кучи просто выбрасываем
+        if (!inOpen[top.node] || openKey[top.node] < top.key || top.key < openKey[top.node]) {
+            pop();
+            continue;
+        }
+        if (!(top.key < calculateKey(startIndex)) && rhs[startIndex] == g[startIndex]) {
+            break;
+        }
+        if (expansions++ >= maxExpansions) {
+            return false;
+        }
+
+        OpenEntry entry = pop();
+        int node = entry.node;
+        Key newKey = calculateKey(node);
+
+        if (entry.key < newKey) {
+            push(node);
+        } else if (g[node] > rhs[node]) {
+            g[node] = rhs[node];
+            inOpen[node] = 0;
+            if (!passable(node)) {
+                continue;
+            }
+            forEachNeighbor(node, [&](int next, float step) {
+                if (next != goalIndex && passable(next)) {
+                    rhs[next] = std::min(rhs[next], step + g[node]);
+                    updateMembership(next);
+                }
+            });
+        } else {
+            float oldG = g[node];
+            g[node] = INF;
+            forEachNeighbor(node, [&](int next, float step) {
+                if (next != goalIndex && rhs[next] == step + oldG) {
+                    rhs[next] = bestNeighbor(next);
+                    updateMembership(next);
+                }
+            });
+            if (node != goalIndex) {
+                rhs[node] = bestNeighbor(node);
+            }
+            updateMembership(node);
+        }
+    }
+    return true;
+}
+
+bool DStarLite::extractPath(std::vector<glm::vec3>& path) const {
+    path.clear();
+    int node = startIndex;
+    if (g[node] == INF) {
+        return false;
+    }
+
+    path.push_back(grid->centerOf(startCell));
+    int limit = grid->cellCount();
+    while (node != goalIndex && limit-- > 0) {
+        int best = -1;
+        float bestCost = INF;
+        forEachNeighbor(node, [&](int next, float step) {
+            float total = step + g[next];
+            if (passable(next) && total < bestCost) {
+                bestCost = total;
+                best = next;
+            }
+        });
+        if (best < 0) {
+            path.clear();
+            return false;
+        }
+        node = best;
+        path.push_back(grid->centerOf(grid->cellOf(node)));
+    }
+    return node == goalIndex;
+}
+
+// Спрямление пути: пропускаем точки, если следующая видна напрямую
+void smoothPath(const OccupancyGrid& grid, std::vector<glm::vec3>& path) {
+    if (path.size() < 3) {
+        return;
+    }
+    size_t write = 1;
+    size_t anchor = 0;
+    for (size_t i = 2; i < path.size(); ++i) {
+        if (!grid.segmentFree(path[anchor], path[i])) {
+            path[write] = path[i - 1];
+            anchor = write;
+            ++write;
+        }
+    }
+    path[write++] = path.back();
+    path.resize(write);
+}
+
+// ---------------------------------------------------------------------------
+// Распределение и порядок целей
+// ---------------------------------------------------------------------------
+
+std::vector<std::vector<int>> assignTargets(const std::vector<glm::vec3>& airships,
+                                            const std::vector<glm::vec3>& targets) {
+    std::vector<std::vector<int>> tours(airships.size());
+    if (airships.empty()) {
+        return tours;
+    }
+
+    // Каждый дирижабль по очереди забирает ближайшую к своей последней точке цель.
+    // Так нагрузка делится поровну, а маршруты получаются компактными.
+    size_t capacity = (targets.size() + airships.size() - 1) / airships.size();
+    std::vector<glm::vec3> cursor = airships;
+    std::vector<uint8_t> taken(targets.size(), 0);
+    size_t remaining = targets.size();
+
+    for (auto& tour : tours) {
+        tour.reserve(capacity);
+    }
+
+    while (remaining > 0) {
+        for (size_t a = 0; a < airships.size() && remaining > 0; ++a) {
+            int best = -1;
+            float bestDistance = INF;
+            for (size_t t = 0; t < targets.size(); ++t) {
+                if (taken[t]) {
+                    continue;
+                }
+                float d = horizontalDistance(cursor[a], targets[t]);
+                if (d < bestDistance) {
+                    bestDistance = d;
+                    best = (int)t;
+                }
+            }
+            taken[best] = 1;
+            tours[a].push_back(best);
+            cursor[a] = targets[best];
+            --remaining;
+        }
+    }
+    return tours;
+}
+
+void improveTour(std::vector<int>& tour, const std::vector<glm::vec3>& points,
+                 const glm::vec3& start, float maxMilliseconds) {
+    size_t n = tour.size();
+    if (n < 3) {
+        return;
+    }
+    Clock::time_point began = Clock::now();
+
+    // Позиция i в маршруте; 0 — стартовая точка дирижабля
+    auto at = [&](size_t i) -> const glm::vec3& {
+        return i == 0 ? start : points[tour[i - 1]];
+    };
+    auto dist = [&](size_t i, size_t j) {
+        return horizontalDistance(at(i), at(j));
+    };
+
+    // Ближайший сосед как начальное решение
+    for (size_t i = 0; i + 1 < n; ++i) {
+        size_t best = i;
+        float bestDistance = INF;
+        for (size_t j = i; j < n; ++j) {
+            float d = horizontalDistance(at(i), points[tour[j]]);
+            if (d < bestDistance) {
+                bestDistance = d;
+                best = j;
+            }
+        }
+        std::swap(tour[i], tour[best]);
+    }
+
+    bool improved = true;
+    while (improved && millisecondsSince(began) < maxMilliseconds) {
+        improved = false;
+
+        // 2-opt: разворот отрезка [i+1, j]; маршрут незамкнутый, поэтому
+        // последнее ребро может отсутствовать
+        for (size_t i = 0; i + 1 < n && millisecondsSince(began) < maxMilliseconds; ++i) {
+            for (size_t j = i + 2; j <= n; ++j) {
+                float before = dist(i, i + 1) + (j < n ? dist(j, j + 1) : 0.0f);
+                float after = dist(i, j) + (j < n ? dist(i + 1, j + 1) : 0.0f);
+                if (after + 1e-4f < before) {
+                    std::reverse(tour.begin() + i, tour.begin() + j);
+                    improved = true;
+                }
+            }
+        }
+
+        // Or-opt: перенос отрезка из 1..3 целей в другое место маршрута
+        for (size_t length = 1; length <= 3 && length < n; ++length) {
+            for (size_t i = 1; i + length <= n && millisecondsSince(began) < maxMilliseconds; ++i) {
+                size_t first = i;
+                size_t last = i + length - 1;
+                float removeGain = dist(first - 1, first)
+                                 + (last < n ? dist(last, last + 1) : 0.0f)
+                                 - (last < n ? dist(first - 1, last + 1) : 0.0f);
+
+                for (size_t j = 0; j <= n; ++j) {
+                    if (j + 1 >= first && j <= last) {
+                        continue;
+                    }
+                    // Вставка между j и j+1
+                    float insertCost = horizontalDistance(at(j), at(first))
+                                     + (j < n ? horizontalDistance(at(last), at(j + 1)) - dist(j, j + 1) : 0.0f);
+                    if (insertCost + 1e-4f < removeGain) {
+                        std::vector<int> segment(tour.begin() + (first - 1), tour.begin() + last);
+                        tour.erase(tour.begin() + (first - 1), tour.begin() + last);
+                        size_t insertAt = j < first ? j : j - length;
+                        tour.insert(tour.begin() + insertAt, segment.begin(), segment.end());
+                        improved = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Пул потоков
+// ---------------------------------------------------------------------------
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::runChunk(const std::function<void(size_t)>* fn, size_t count, uint32_t chunkGeneration) {
+    size_t processed = 0;
+    uint64_t current = cursor.load();
+    while (true) {
+        size_t index = static_cast<size_t>(current & 0xffffffffu);
+        if (static_cast<uint32_t>(current >> 32) != chunkGeneration || index >= count) {
+            break;
+        }
+        if (!cursor.compare_exchange_weak(current, current + 1)) {
+            continue;   // current обновлён — пробуем снова
+        }
+        (*fn)(index);   // Разыменовываем только после захвата индекса: поколение ещё живо
+        ++processed;
+        current = cursor.load();
+    }
+    return processed;
+}
+
+void ThreadPool::workerLoop() {
+    uint32_t seen = 0;
+    while (true) {
+        const std::function<void(size_t)>* fn;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            fn = task;
+            count = taskCount;
+        }
+
+        // parallelFor мог закончиться раньше, чем поток проснулся, — тогда task уже сброшен
+        if (fn == nullptr) {
+            continue;
+        }
+        size_t processed = runChunk(fn, count, seen);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        // Элементы взяты только в своём поколении, и пока они не учтены, оно не закончится
+        if (generation == seen && processed > 0) {
+            finished += processed;
+            if (finished == taskCount) {
+                done.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    uint32_t chunkGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        taskCount = count;
+        finished = 0;
+        chunkGeneration = ++generation;
+        cursor = static_cast<uint64_t>(chunkGeneration) << 32;
+    }
+    wake.notify_all();
+
+    size_t processed = runChunk(&fn, count, chunkGeneration);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished += processed;
+    done.wait(lock, [&] { return finished == taskCount; });
+    task = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Планировщик
+// ---------------------------------------------------------------------------
+
+void reserve(PlanRequest& request, const PlanCapacity& capacity) {
+    request.airships.reserve(capacity.airships);
+    request.targets.reserve(capacity.targets);
+    request.obstacles.reserve(capacity.obstacles);
+}
+
+void reserve(PlanResult& result, const PlanCapacity& capacity) {
+    result.airships.reserve(capacity.airships);
+}
+
+RoutePlanner::RoutePlanner(const GridSettings& settings, unsigned threadCount, const PlanCapacity& capacity)
+    : gridSettings(settings), planCapacity(capacity), pool(new ThreadPool(threadCount)) {
+    grids[0].resize(gridSettings);
+    grids[1].resize(gridSettings);
+    reserve(request, planCapacity);
+    reserve(result, planCapacity);
+    coordinator = std::thread(&RoutePlanner::coordinatorLoop, this);
+}
+
+RoutePlanner::~RoutePlanner() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    coordinator.join();
+}
+
+bool RoutePlanner::submit(PlanRequest& newRequest) {
+    if (pending.exchange(true)) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(request, newRequest);
+        hasRequest = true;
+    }
+    wake.notify_one();
+    return true;
+}
+
+bool RoutePlanner::poll(PlanResult& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasResult) {
+        return false;
+    }
+    std::swap(out, result);
+    hasResult = false;
+    pending = false;
+    return true;
+}
+
+void RoutePlanner::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait(lock, [&] { return hasResult || !pending.load(); });
+}
+
+void RoutePlanner::coordinatorLoop() {
+    PlanRequest job;
+    PlanResult out;
+    reserve(job, planCapacity);
+    reserve(out, planCapacity);
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || hasRequest; });
+            if (stopping) {
+                return;
+            }
+            std::swap(job, request);
+            hasRequest = false;
+        }
+
+        process(job, out);
+
+        // Буферы запроса возвращаются в request — их получит следующий submit
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(result, out);
+            std::swap(request, job);
+            hasResult = true;
+        }
+        ready.notify_all();
+    }
+}
+
+void RoutePlanner::process(const PlanRequest& job, PlanResult& out) {
+    // 1. Новая сетка занятости и список изменившихся ячеек
+    Clock::time_point gridStart = Clock::now();
+    int next = 1 - currentGrid;
+    OccupancyGrid& grid = grids[next];
+    grid.clear();
+    for (const auto& obstacle : job.obstacles) {
+        grid.markObstacle(obstacle, gridSettings.predictionHorizon, gridSettings.safetyMargin);
+    }
+    if (gridValid) {
+        grid.diff(grids[currentGrid], changedCells);
+    }
+    currentGrid = next;
+    out.gridMilliseconds = millisecondsSince(gridStart);
+
+    // out переиспользуется между запросами — всё, что не перезапишется ниже, сбрасываем
+    out.toursUpdated = false;
+    out.tourMilliseconds = 0.0f;
+    out.airships.resize(job.airships.size());
+    for (size_t i = 0; i < job.airships.size(); ++i) {
+        out.airships[i].id = job.airships[i].id;
+        out.airships[i].complete = true;
+        out.airships[i].tour.clear();
+        out.airships[i].path.clear();
+        // Новые планы получают полную ёмкость сразу; у прежних reserve ничего не делает
+        out.airships[i].tour.reserve(planCapacity.targets);
+        out.airships[i].path.reserve(planCapacity.pathLength);
+    }
+
+    // 2. Распределение целей и TSP — каждый маршрут улучшается на своём потоке
+    if (job.reassignTargets) {
+        Clock::time_point tourStart = Clock::now();
+        std::vector<glm::vec3> starts(job.airships.size());
+        for (size_t i = 0; i < job.airships.size(); ++i) {
+            starts[i] = job.airships[i].position;
+        }
+        std::vector<std::vector<int>> tours = assignTargets(starts, job.targets);
+
+        pool->parallelFor(tours.size(), [&](size_t i) {
+            improveTour(tours[i], job.targets, starts[i], job.tourBudgetMilliseconds);
+        });
+        for (size_t i = 0; i < tours.size(); ++i) {
+            out.airships[i].tour.assign(tours[i].begin(), tours[i].end());   // Копия — буфер плана не теряет ёмкость
+        }
+        out.toursUpdated = true;
+        out.tourMilliseconds = millisecondsSince(tourStart);
+    }
+
+    // 3. Пути до текущих целей. Поиск для каждого дирижабля хранится между
+    //    запросами и только дообновляется по изменившимся ячейкам.
+    Clock::time_point pathStart = Clock::now();
+    std::vector<DStarLite*> slots(job.airships.size(), nullptr);
+    for (size_t i = 0; i < job.airships.size(); ++i) {
+        if (job.airships[i].hasGoal) {
+            slots[i] = &searches[job.airships[i].id];
+        }
+    }
+
+    // Поиски, которые не попали в запрос (дирижабль удалён), выбрасываем
+    for (auto it = searches.begin(); it != searches.end();) {
+        bool used = false;
+        for (const auto& airship : job.airships) {
+            used = used || (airship.id == it->first && airship.hasGoal);
+        }
+        it = used ? std::next(it) : searches.erase(it);
+    }
+
+    bool incremental = gridValid;
+    pool->parallelFor(slots.size(), [&](size_t i) {
+        DStarLite* search = slots[i];
+        if (!search) {
+            return;
+        }
+        const AirshipState& airship = job.airships[i];
+        glm::ivec3 startCell = grid.cellAt(airship.position);
+        glm::ivec3 goalCell = grid.cellAt(airship.goal);
+
+        if (!search->initialized() || search->goal() != goalCell || !incremental) {
+            search->reset(&grid, startCell, goalCell);
+        } else {
+            // Сетки чередуются, но имеют одинаковый размер, поэтому прежнее
+            // состояние поиска остаётся верным — подправляем только изменения
+            search->attach(&grid);
+            search->moveStart(startCell);
+            search->cellsChanged(changedCells);
+        }
+
+        AirshipPlan& plan = out.airships[i];
+        plan.complete = search->computeShortestPath(job.maxExpansions);
+        if (plan.complete && search->extractPath(plan.path)) {
+            plan.path.front() = airship.position;
+            plan.path.back() = airship.goal;
+            smoothPath(grid, plan.path);
+        } else {
+            plan.path.clear();
+        }
+    });
+    gridValid = true;
+    out.pathMilliseconds = millisecondsSince(pathStart);
+}
+
+} // namespace planner
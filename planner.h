@@ -0,0 +1,248 @@
+#pragma once
+
+// Планировщик маршрутов доставки.
+// - Цели распределяются между дирижаблями и упорядочиваются эвристикой TSP
+//   (ближайший сосед + 2-opt + Or-opt), каждый дирижабль — на своём потоке.
+// - Путь до текущей цели ищется D* Lite по трёхмерной сетке занятости,
+//   где отмечены тучи в текущем и предсказанном положении.
+// - При движении туч сетка сравнивается с предыдущей, и D* Lite
+//   пересчитывает только затронутую часть, а не ищет путь заново.
+// Вся тяжёлая работа идёт на фоновых потоках; основной поток только
+// отправляет снимок сцены (submit) и забирает готовый результат (poll).
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace planner {
+
+// Препятствие — эллипсоид, движущийся с постоянной скоростью
+struct Obstacle {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec3 extent;   // Полуоси эллипсоида
+};
+
+struct GridSettings {
+    glm::vec3 minCorner = glm::vec3(-120.0f, 0.0f, -120.0f);
+    glm::vec3 maxCorner = glm::vec3(120.0f, 64.0f, 120.0f);
+    float cellSize = 4.0f;
+    float predictionHorizon = 6.0f;   // На сколько секунд вперёд отмечаем тучи
+    float safetyMargin = 2.0f;        // Запас вокруг препятствий
+};
+
+class OccupancyGrid {
+public:
+    void resize(const GridSettings& settings);
+    void clear();
+    void markObstacle(const Obstacle& obstacle, float horizon, float margin);
+
+    int cellCount() const { return static_cast<int>(cells.size()); }
+    bool inside(const glm::ivec3& cell) const;
+    int index(const glm::ivec3& cell) const { return (cell.y * dims.z + cell.z) * dims.x + cell.x; }
+    glm::ivec3 cellOf(int index) const;
+    glm::ivec3 cellAt(const glm::vec3& position) const;
+    glm::vec3 centerOf(const glm::ivec3& cell) const;
+    bool blocked(int index) const { return cells[index] != 0; }
+    bool segmentFree(const glm::vec3& from, const glm::vec3& to) const;
+
+    // Индексы ячеек, которые отличаются в двух сетках одинакового размера
+    void diff(const OccupancyGrid& previous, std::vector<int>& changed) const;
+
+    const glm::ivec3& size() const { return dims; }
+
+private:
+    glm::vec3 origin = glm::vec3(0.0f);
+    float cellSize = 1.0f;
+    glm::ivec3 dims = glm::ivec3(0);
+    std::vector<uint8_t> cells;
+};
+
+// Инкрементальный поиск пути D* Lite (Koenig, Likhachev) на 26-связной сетке.
+// Поиск идёт от цели к старту, поэтому движение дирижабля и изменение
+// препятствий не требуют пересчёта с нуля.
+class DStarLite {
+public:
+    void reset(const OccupancyGrid* grid, const glm::ivec3& start, const glm::ivec3& goal);
+    // Подмена сетки того же размера без сброса состояния поиска
+    void attach(const OccupancyGrid* grid);
+    void moveStart(const glm::ivec3& start);
+    void cellsChanged(const std::vector<int>& changed);
+    // Возвращает false, если лимит раскрытий исчерпан — продолжим в следующий раз
+    bool computeShortestPath(int maxExpansions);
+    bool extractPath(std::vector<glm::vec3>& path) const;
+
+    const glm::ivec3& goal() const { return goalCell; }
+    bool initialized() const { return grid != nullptr; }
+
+private:
+    struct Key {
+        float k1, k2;
+        bool operator<(const Key& other) const { return k1 < other.k1 || (k1 == other.k1 && k2 < other.k2); }
+    };
+
+    struct OpenEntry {
+        Key key;
+        int node;
+    };
+
+    const OccupancyGrid* grid = nullptr;
+    glm::ivec3 startCell = glm::ivec3(0);
+    glm::ivec3 goalCell = glm::ivec3(0);
+    int startIndex = 0;
+    int goalIndex = 0;
+    int lastStart = 0;
+    float km = 0.0f;
+    std::vector<float> g;
+    std::vector<float> rhs;
+    std::vector<Key> openKey;
+    std::vector<uint8_t> inOpen;
+    std::vector<OpenEntry> open;   // Двоичная куча с ленивым удалением
+    std::vector<int> touched;
+
+    float heuristic(int a, int b) const;
+    bool passable(int node) const;
+    float bestNeighbor(int node) const;
+    Key calculateKey(int node) const;
+    void updateMembership(int node);
+    void push(int node);
+    OpenEntry pop();
+    // fn(соседняя ячейка, цена шага)
+    template <typename Fn>
+    void forEachNeighbor(int node, Fn&& fn) const;
+};
+
+void smoothPath(const OccupancyGrid& grid, std::vector<glm::vec3>& path);
+
+// Распределение целей между дирижаблями (сбалансированный жадный выбор ближайшего)
+std::vector<std::vector<int>> assignTargets(const std::vector<glm::vec3>& airships,
+                                            const std::vector<glm::vec3>& targets);
+
+// Улучшение незамкнутого маршрута из точки start: 2-opt и перенос отрезков (Or-opt)
+void improveTour(std::vector<int>& tour, const std::vector<glm::vec3>& points,
+                 const glm::vec3& start, float maxMilliseconds);
+
+// Пул потоков с единственной операцией parallelFor; вызывающий поток тоже работает
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount);
+    ~ThreadPool();
+
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* task = nullptr;
+    size_t taskCount = 0;
+    // Старшие 32 бита — поколение, младшие — следующий индекс. Индекс берётся
+    // только для своего поколения: отставший поток не заберёт элемент у следующего вызова
+    std::atomic<uint64_t> cursor{0};
+    size_t finished = 0;
+    uint32_t generation = 0;
+    bool stopping = false;
+
+    void workerLoop();
+    size_t runChunk(const std::function<void(size_t)>* fn, size_t count, uint32_t chunkGeneration);
+};
+
+struct AirshipState {
+    uint32_t id;
+    glm::vec3 position;
+    glm::vec3 goal;
+    bool hasGoal;
+};
+
+struct PlanRequest {
+    std::vector<AirshipState> airships;
+    std::vector<glm::vec3> targets;      // Заполняется, если нужно заново распределить цели
+    std::vector<Obstacle> obstacles;
+    bool reassignTargets = false;
+    float tourBudgetMilliseconds = 4.0f;
+    int maxExpansions = 20000;           // Лимит раскрытий D* Lite на дирижабль
+};
+
+struct AirshipPlan {
+    uint32_t id;
+    std::vector<int> tour;               // Индексы PlanRequest::targets (если было распределение)
+    std::vector<glm::vec3> path;         // Пусто, если путь не найден или не нужен
+    bool complete;                       // false — поиск упёрся в лимит, путь будет уточнён
+};
+
+struct PlanResult {
+    std::vector<AirshipPlan> airships;
+    bool toursUpdated = false;
+    float gridMilliseconds = 0.0f;
+    float tourMilliseconds = 0.0f;
+    float pathMilliseconds = 0.0f;
+};
+
+// Ёмкость буферов обмена. Запрос и результат ходят обменом между тремя экземплярами
+// (у вызывающего, в RoutePlanner и у координатора), поэтому резервируется каждый
+struct PlanCapacity {
+    size_t airships = 16;
+    size_t targets = 1024;
+    size_t obstacles = 1024;
+    size_t pathLength = 64;
+};
+
+void reserve(PlanRequest& request, const PlanCapacity& capacity);
+// Планы дирижаблей создаются при первом ответе — их туры и пути резервирует process()
+void reserve(PlanResult& result, const PlanCapacity& capacity);
+
+class RoutePlanner {
+public:
+    explicit RoutePlanner(const GridSettings& settings = GridSettings(), unsigned threadCount = 0,
+                          const PlanCapacity& capacity = PlanCapacity());
+    ~RoutePlanner();
+
+    bool busy() const { return pending.load(); }
+    // Возвращает false, если предыдущий запрос ещё считается.
+    // Запрос и результат передаются обменом: взамен вызывающий получает буферы
+    // прошлого запроса/результата и заполняет их заново без выделения памяти
+    bool submit(PlanRequest& request);
+    bool poll(PlanResult& result);
+    // Блокирует до готовности результата отправленного запроса (сам результат забирает poll).
+    // Нужен пакетным прогонам, которые не должны зависеть от скорости фонового потока
+    void wait();
+
+    const GridSettings& settings() const { return gridSettings; }
+
+private:
+    GridSettings gridSettings;
+    PlanCapacity planCapacity;
+    std::unique_ptr<ThreadPool> pool;
+    std::thread coordinator;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable ready;
+    bool stopping = false;
+    bool hasRequest = false;
+    bool hasResult = false;
+    std::atomic<bool> pending{false};
+    PlanRequest request;
+    PlanResult result;
+
+    // Принадлежат потоку-координатору
+    OccupancyGrid grids[2];
+    int currentGrid = 0;
+    bool gridValid = false;
+    std::vector<int> changedCells;
+    std::unordered_map<uint32_t, DStarLite> searches;
+
+    void coordinatorLoop();
+    void process(const PlanRequest& job, PlanResult& out);
+};
+
+} // namespace planner
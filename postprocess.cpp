@@ -0,0 +1,405 @@
+#include "postprocess.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+const float BLOOM_THRESHOLD = 1.0f;   // Светится то, что ярче белого
+const float BLOOM_KNEE = 0.5f;        // Мягкий переход около порога
+const float BLOOM_INTENSITY = 0.6f;
+const int MIN_BLOOM_SIZE = 8;         // Меньше уровни не делаем — от них только размытое пятно
+
+const char* fullscreenVertexShader = R"(
+    #version 330 core
+    void main() {
+        vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+        gl_Position = vec4(position, 0.0, 1.0);
+    }
+)";
+
+// Уменьшение вдвое: четыре билинейные выборки = среднее по квадрату 4×4 исходных пикселей.
+// На первом шаге ещё и отсекаются тёмные области
+const char* downsampleShader = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    uniform sampler2D source;
+    uniform vec2 inverseSourceSize;
+    uniform vec2 inverseTargetSize;
+    uniform bool prefilter;
+    uniform float threshold;
+    uniform float knee;
+
+    void main() {
+        vec2 uv = gl_FragCoord.xy * inverseTargetSize;
+        vec3 color = 0.25 * (texture(source, uv + vec2(-1.0, -1.0) * inverseSourceSize).rgb
+                           + texture(source, uv + vec2(1.0, -1.0) * inverseSourceSize).rgb
+                           + texture(source, uv + vec2(-1.0, 1.0) * inverseSourceSize).rgb
+                           + texture(source, uv + vec2(1.0, 1.0) * inverseSourceSize).rgb);
+
+        if (prefilter) {
+            float brightness = max(color.r, max(color.g, color.b));
+            float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+            soft = soft * soft / (4.0 * knee + 1e-5);
+            color *= max(soft, brightness - threshold) / max(brightness, 1e-5);
+        }
+        FragColor = vec4(color, 1.0);
+    }
+)";
+
+// Увеличение вдвое фильтром-палаткой 3×3; результат добавляется к уровню выше
+const char* upsampleShader = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    uniform sampler2D source;
+    uniform vec2 inverseSourceSize;
+    uniform vec2 inverseTargetSize;
+
+    void main() {
+        vec2 uv = gl_FragCoord.xy * inverseTargetSize;
+        vec2 d = inverseSourceSize;
+        vec3 color = texture(source, uv).rgb * 4.0;
+        color += (texture(source, uv + vec2(-d.x, 0.0)).rgb + texture(source, uv + vec2(d.x, 0.0)).rgb
+                + texture(source, uv + vec2(0.0, -d.y)).rgb + texture(source, uv + vec2(0.0, d.y)).rgb) * 2.0;
+        color += texture(source, uv + vec2(-d.x, -d.y)).rgb + texture(source, uv + vec2(d.x, -d.y)).rgb
+               + texture(source, uv + vec2(-d.x, d.y)).rgb + texture(source, uv + vec2(d.x, d.y)).rgb;
+        FragColor = vec4(color / 16.0, 1.0);
+    }
+)";
+
+// Экспозиция, bloom и аппроксимация кривой ACES (К. Наркович)
+const char* tonemapShader = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    uniform sampler2D hdrColor;
+    uniform sampler2D bloom;
+    uniform bool useBloom;
+    uniform vec2 inverseTargetSize;
+    uniform float exposure;
+    uniform float bloomIntensity;
+
+    vec3 aces(vec3 x) {
+        return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+    }
+
+    void main() {
+        vec2 uv = gl_FragCoord.xy * inverseTargetSize;
+        vec3 color = texture(hdrColor, uv).rgb;
+        if (useBloom) {
+            color += texture(bloom, uv).rgb * bloomIntensity;
+        }
+        FragColor = vec4(aces(color * exposure), 1.0);
+    }
+)";
+
+GLuint compileShader(GLenum type, const char* source, const char* name) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << name << " shader compilation failed:\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+GLuint linkProgram(const char* fragmentSource, const char* name) {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, fullscreenVertexShader, name);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, name);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << name << " program linking failed:\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+size_t bytesPerPixel(GLenum format) {
+    return format == GL_RGBA16F ? 8 : 4;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Пул целей
+// ---------------------------------------------------------------------------
+
+void RenderTargetPool::init(size_t budget) {
+    budgetBytes = budget;
+    targets.reserve(16);
+}
+
+void RenderTargetPool::destroy() {
+    for (RenderTarget& target : targets) {
+        glDeleteFramebuffers(1, &target.framebuffer);
+        glDeleteTextures(1, &target.color);
+        if (target.depth) {
+            glDeleteTextures(1, &target.depth);
+        }
+    }
+    targets.clear();
+    totalBytes = 0;
+}
+
+int RenderTargetPool::acquire(int width, int height, GLenum format, bool withDepth) {
+    for (size_t i = 0; i < targets.size(); ++i) {
+        RenderTarget& target = targets[i];
+        if (!target.inUse && target.width == width && target.height == height
+            && target.format == format && (target.depth != 0) == withDepth) {
+            target.inUse = true;
+            return int(i);
+        }
+    }
+
+    size_t bytes = size_t(width) * height * (bytesPerPixel(format) + (withDepth ? 4 : 0));
+    if (totalBytes + bytes > budgetBytes) {
+        rejectedCount++;
+        return NO_TARGET;
+    }
+
+    RenderTarget target;
+    target.width = width;
+    target.height = height;
+    target.format = format;
+    target.bytes = bytes;
+    target.inUse = true;
+
+    glGenTextures(1, &target.color);
+    glBindTexture(GL_TEXTURE_2D, target.color);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &target.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.color, 0);
+
+    // Глубина в том же формате, что у окна, — частицы копируют её blit-ом
+    if (withDepth) {
+        glGenTextures(1, &target.depth);
+        glBindTexture(GL_TEXTURE_2D, target.depth);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, target.depth, 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Render target " << width << "x" << height << " is incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    totalBytes += bytes;
+    targets.push_back(target);
+    return int(targets.size() - 1);
+}
+
+void RenderTargetPool::release(int target) {
+    if (target != NO_TARGET) {
+        targets[target].inUse = false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Конвейер
+// ---------------------------------------------------------------------------
+
+bool PostProcess::init(int viewportWidth, int viewportHeight, size_t budgetBytes) {
+    width = viewportWidth;
+    height = viewportHeight;
+    pool.init(budgetBytes);
+    std::fill(bloomTargets, bloomTargets + MAX_BLOOM_LEVELS, int(RenderTargetPool::NO_TARGET));
+
+    prefilterProgram = linkProgram(downsampleShader, "Bloom prefilter");
+    downsampleProgram = linkProgram(downsampleShader, "Bloom downsample");
+    upsampleProgram = linkProgram(upsampleShader, "Bloom upsample");
+    tonemapProgram = linkProgram(tonemapShader, "Tonemap");
+    glGenVertexArrays(1, &emptyVAO);
+
+    glUseProgram(prefilterProgram);
+    glUniform1i(glGetUniformLocation(prefilterProgram, "source"), 0);
+    glUniform1i(glGetUniformLocation(prefilterProgram, "prefilter"), 1);
+    glUniform1f(glGetUniformLocation(prefilterProgram, "threshold"), BLOOM_THRESHOLD);
+    glUniform1f(glGetUniformLocation(prefilterProgram, "knee"), BLOOM_KNEE);
+    glUseProgram(downsampleProgram);
+    glUniform1i(glGetUniformLocation(downsampleProgram, "source"), 0);
+    glUniform1i(glGetUniformLocation(downsampleProgram, "prefilter"), 0);
+    glUseProgram(upsampleProgram);
+    glUniform1i(glGetUniformLocation(upsampleProgram, "source"), 0);
+    glUseProgram(tonemapProgram);
+    glUniform1i(glGetUniformLocation(tonemapProgram, "hdrColor"), 0);
+    glUniform1i(glGetUniformLocation(tonemapProgram, "bloom"), 1);
+    glUniform1f(glGetUniformLocation(tonemapProgram, "bloomIntensity"), BLOOM_INTENSITY);
+    glUseProgram(0);
+
+    // HDR-цель нужна сразу: без неё кадр рисовать некуда
+    for (TimerSlot& slot : timers) {
+        glGenQueries(3, slot.queries);
+    }
+
+    hdrTarget = pool.acquire(width, height, GL_RGBA16F, true);
+    pool.release(hdrTarget);
+    return hdrTarget != RenderTargetPool::NO_TARGET;
+}
+
+void PostProcess::destroy() {
+    for (TimerSlot& slot : timers) {
+        glDeleteQueries(3, slot.queries);
+        slot.pending = false;
+    }
+    pool.destroy();
+    glDeleteProgram(prefilterProgram);
+    glDeleteProgram(downsampleProgram);
+    glDeleteProgram(upsampleProgram);
+    glDeleteProgram(tonemapProgram);
+    glDeleteVertexArrays(1, &emptyVAO);
+}
+
+void PostProcess::collectTimers(TimerSlot& slot) {
+    if (!slot.pending) {
+        return;
+    }
+    GLuint64 stamps[3];
+    for (int i = 0; i < 3; ++i) {
+        glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &stamps[i]);
+    }
+    timedFrames++;
+    bloomMilliseconds += (stamps[1] - stamps[0]) / 1.0e6;
+    tonemapMilliseconds += (stamps[2] - stamps[1]) / 1.0e6;
+    slot.pending = false;
+}
+
+GLuint PostProcess::beginFrame() {
+    hdrTarget = pool.acquire(width, height, GL_RGBA16F, true);
+    return hdrTarget == RenderTargetPool::NO_TARGET ? 0 : pool[hdrTarget].framebuffer;
+}
+
+void PostProcess::drawFullscreen(GLuint program, GLuint source, const RenderTarget* target) {
+    glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+    glViewport(0, 0, target->width, target->height);
+    glUseProgram(program);
+    glUniform2f(glGetUniformLocation(program, "inverseTargetSize"), 1.0f / target->width, 1.0f / target->height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source);
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void PostProcess::finish(GLuint output) {
+    if (hdrTarget == RenderTargetPool::NO_TARGET) {
+        return;
+    }
+    TimerSlot& slot = timers[timerIndex];
+    collectTimers(slot);
+    glQueryCounter(slot.queries[0], GL_TIMESTAMP);
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    // Цепочка уменьшений: первый уровень — половина кадра с отсечением тёмного.
+    // Текстура копируется: acquire() ниже может расширить пул и сдвинуть его элементы
+    GLuint hdrColor = pool[hdrTarget].color;
+    int levels = 0;
+    int levelWidth = width / 2;
+    int levelHeight = height / 2;
+    GLuint source = hdrColor;
+    int sourceWidth = width;
+    int sourceHeight = height;
+    while (levels < MAX_BLOOM_LEVELS && std::min(levelWidth, levelHeight) >= MIN_BLOOM_SIZE) {
+        int target = pool.acquire(levelWidth, levelHeight, GL_RGBA16F, false);
+        if (target == RenderTargetPool::NO_TARGET) {
+            break;   // Бюджет исчерпан — обходимся тем, что есть
+        }
+        bloomTargets[levels] = target;
+
+        GLuint program = levels == 0 ? prefilterProgram : downsampleProgram;
+        glUseProgram(program);
+        glUniform2f(glGetUniformLocation(program, "inverseSourceSize"), 1.0f / sourceWidth, 1.0f / sourceHeight);
+        drawFullscreen(program, source, &pool[target]);
+
+        source = pool[target].color;
+        sourceWidth = levelWidth;
+        sourceHeight = levelHeight;
+        levelWidth /= 2;
+        levelHeight /= 2;
+        ++levels;
+    }
+    minBloomLevels = std::min(minBloomLevels, levels);
+
+    // Обратный проход: каждый уровень добавляется к следующему по размеру
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glUseProgram(upsampleProgram);
+    for (int level = levels - 1; level > 0; --level) {
+        const RenderTarget& small = pool[bloomTargets[level]];
+        glUniform2f(glGetUniformLocation(upsampleProgram, "inverseSourceSize"), 1.0f / small.width, 1.0f / small.height);
+        drawFullscreen(upsampleProgram, small.color, &pool[bloomTargets[level - 1]]);
+    }
+    glDisable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glQueryCounter(slot.queries[1], GL_TIMESTAMP);
+
+    // Итог: экспозиция, bloom, тональная кривая
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    glViewport(0, 0, width, height);
+    glUseProgram(tonemapProgram);
+    glUniform2f(glGetUniformLocation(tonemapProgram, "inverseTargetSize"), 1.0f / width, 1.0f / height);
+    glUniform1f(glGetUniformLocation(tonemapProgram, "exposure"), exposure);
+    glUniform1i(glGetUniformLocation(tonemapProgram, "useBloom"), levels > 0 ? 1 : 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, levels > 0 ? pool[bloomTargets[0]].color : 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, hdrColor);
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glQueryCounter(slot.queries[2], GL_TIMESTAMP);
+    slot.pending = true;
+    timerIndex = (timerIndex + 1) % TIMER_FRAMES;
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+
+    // Все цели возвращаются в пул до следующего кадра
+    for (int level = 0; level < levels; ++level) {
+        pool.release(bloomTargets[level]);
+        bloomTargets[level] = RenderTargetPool::NO_TARGET;
+    }
+    pool.release(hdrTarget);
+    hdrTarget = RenderTargetPool::NO_TARGET;
+}
+
+void PostProcess::printStats() {
+    for (TimerSlot& slot : timers) {
+        collectTimers(slot);
+    }
+    std::cout << "Render target pool: " << pool.size() << " targets, " << pool.bytes() / 1024 << " of "
+              << pool.budget() / 1024 << " KiB, bloom levels >= " << minBloomLevels
+              << ", rejected by budget: " << pool.rejected() << std::endl;
+    if (timedFrames > 0) {
+        std::cout << "Post-process GPU cost, ms per frame: bloom " << bloomMilliseconds / timedFrames
+                  << ", tonemap " << tonemapMilliseconds / timedFrames << " (" << timedFrames << " frames)" << std::endl;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+// HDR-конвейер кадра.
+// - Сцена рисуется в цель с плавающей точкой (RGBA16F), поэтому вспышки молний,
+//   солнце и центр прожектора могут быть ярче 1.0.
+// - Bloom: яркие области (выше порога, с мягким коленом) переносятся в цель
+//   половинного разрешения, затем цепочка уменьшений вдвое и обратный проход
+//   увеличений с аддитивным смешиванием (фильтр-палатка 3×3).
+// - Итоговый проход: экспозиция, bloom и тональная кривая ACES — в выходной буфер.
+// Цели берутся из RenderTargetPool и возвращаются в него в том же кадре, поэтому
+// после первого кадра ничего не создаётся. Пул не выходит за бюджет видеопамяти:
+// если очередной уровень bloom в бюджет не влезает, цепочка просто короче.
+// Время bloom и тональной кривой на видеокарте меряется метками GL_TIMESTAMP,
+// как у AntiAliasing, — среднее печатает printStats().
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+struct RenderTarget {
+    GLuint framebuffer = 0;
+    GLuint color = 0;
+    GLuint depth = 0;          // Глубина и трафарет (GL_DEPTH24_STENCIL8), если просили
+    int width = 0;
+    int height = 0;
+    GLenum format = GL_RGBA16F;
+    size_t bytes = 0;
+    bool inUse = false;
+};
+
+class RenderTargetPool {
+public:
+    static constexpr int NO_TARGET = -1;
+
+    void init(size_t budgetBytes);
+    void destroy();
+
+    // Свободная цель такого размера и формата или новая, если она влезает в бюджет;
+    // иначе NO_TARGET
+    int acquire(int width, int height, GLenum format, bool withDepth);
+    void release(int target);
+    const RenderTarget& operator[](int target) const { return targets[target]; }
+
+    size_t bytes() const { return totalBytes; }
+    size_t budget() const { return budgetBytes; }
+    size_t size() const { return targets.size(); }
+    int rejected() const { return rejectedCount; }
+
+private:
+    std::vector<RenderTarget> targets;
+    size_t budgetBytes = 0;
+    size_t totalBytes = 0;
+    int rejectedCount = 0;   // Сколько раз бюджет не дал создать цель
+};
+
+class PostProcess {
+public:
+    bool init(int viewportWidth, int viewportHeight, size_t budgetBytes);
+    void destroy();
+
+    // HDR-цель (цвет и глубина), в которую должен попасть кадр до finish()
+    GLuint beginFrame();
+    // Bloom и тональная кривая; результат — в output
+    void finish(GLuint output);
+
+    void setExposure(float value) { exposure = value; }
+
+    // Цели пула, уровни bloom и среднее время проходов — для сводки в конце работы.
+    // Дочитывает метки последних кадров, поэтому вызывать в конце
+    void printStats();
+
+private:
+    static constexpr int MAX_BLOOM_LEVELS = 6;
+
+    int width = 0;
+    int height = 0;
+    float exposure = 1.0f;
+    RenderTargetPool pool;
+    int hdrTarget = RenderTargetPool::NO_TARGET;
+    int bloomTargets[MAX_BLOOM_LEVELS];
+    int minBloomLevels = MAX_BLOOM_LEVELS;   // Самая короткая цепочка за всё время
+
+    GLuint prefilterProgram = 0;
+    GLuint downsampleProgram = 0;
+    GLuint upsampleProgram = 0;
+    GLuint tonemapProgram = 0;
+    GLuint emptyVAO = 0;
+
+    // Метки времени: начало bloom, начало тональной кривой, конец
+    static const int TIMER_FRAMES = 4;
+    struct TimerSlot {
+        GLuint queries[3] = {0, 0, 0};
+        bool pending = false;
+    };
+    TimerSlot timers[TIMER_FRAMES];
+    int timerIndex = 0;
+    int timedFrames = 0;
+    double bloomMilliseconds = 0.0;
+    double tonemapMilliseconds = 0.0;
+
+    void collectTimers(TimerSlot& slot);
+    void drawFullscreen(GLuint program, GLuint source, const RenderTarget* target);
+};
@@ -0,0 +1,126 @@
+#include "scene.h"
+
+#include <algorithm>
+#include <cassert>
+
+void SceneGraph::reserve(size_t count) {
+    locals.reserve(count);
+    worlds.reserve(count);
+    parents.reserve(count);
+    subtreeSizes.reserve(count);
+    dirty.reserve(count);
+    nodeAt.reserve(count);
+    slotOf.reserve(count);
+    freeIds.reserve(count);
+}
+
+SceneGraph::NodeId SceneGraph::create(NodeId parent, const glm::mat4& local) {
+    NodeId node;
+    if (!freeIds.empty()) {
+        node = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        node = NodeId(slotOf.size());
+        slotOf.push_back(INVALID);
+    }
+
+    // Новый узел встаёт сразу за последним потомком родителя — поддерево остаётся непрерывным
+    uint32_t parentSlot = INVALID;
+    uint32_t slot = uint32_t(nodeAt.size());
+    if (parent != INVALID) {
+        assert(isAlive(parent));
+        parentSlot = slotOf[parent];
+        slot = parentSlot + subtreeSizes[parentSlot];
+        for (uint32_t ancestor = parentSlot; ancestor != INVALID; ancestor = parents[ancestor]) {
+            subtreeSizes[ancestor]++;
+        }
+    }
+
+    locals.insert(locals.begin() + slot, local);
+    worlds.insert(worlds.begin() + slot, local);
+    parents.insert(parents.begin() + slot, parentSlot);
+    subtreeSizes.insert(subtreeSizes.begin() + slot, 1u);
+    dirty.insert(dirty.begin() + slot, uint8_t(1));
+    nodeAt.insert(nodeAt.begin() + slot, node);
+    slotOf[node] = slot;
+    reindex(slot + 1, slot, 1);
+
+    firstDirty = std::min(firstDirty, size_t(slot));
+    return node;
+}
+
+void SceneGraph::destroy(NodeId node) {
+    assert(isAlive(node));
+    uint32_t slot = slotOf[node];
+    uint32_t count = subtreeSizes[slot];
+    for (uint32_t ancestor = parents[slot]; ancestor != INVALID; ancestor = parents[ancestor]) {
+        subtreeSizes[ancestor] -= count;
+    }
+
+    for (uint32_t i = slot; i < slot + count; ++i) {
+        slotOf[nodeAt[i]] = INVALID;
+        freeIds.push_back(nodeAt[i]);
+    }
+    locals.erase(locals.begin() + slot, locals.begin() + slot + count);
+    worlds.erase(worlds.begin() + slot, worlds.begin() + slot + count);
+    parents.erase(parents.begin() + slot, parents.begin() + slot + count);
+    subtreeSizes.erase(subtreeSizes.begin() + slot, subtreeSizes.begin() + slot + count);
+    dirty.erase(dirty.begin() + slot, dirty.begin() + slot + count);
+    nodeAt.erase(nodeAt.begin() + slot, nodeAt.begin() + slot + count);
+    reindex(slot, slot + count, -int(count));
+
+    firstDirty = std::min(firstDirty, size_t(slot));
+}
+
+void SceneGraph::reindex(uint32_t from, uint32_t threshold, int delta) {
+    for (uint32_t i = from; i < nodeAt.size(); ++i) {
+        slotOf[nodeAt[i]] = i;
+        if (parents[i] != INVALID && parents[i] >= threshold) {
+            parents[i] = uint32_t(int(parents[i]) + delta);
+        }
+    }
+}
+
+void SceneGraph::setLocal(NodeId node, const glm::mat4& local) {
+    uint32_t slot = slotOf[node];
+    if (locals[slot] == local) {
+        return;
+    }
+    locals[slot] = local;
+    markDirty(slot);
+}
+
+// Если узел уже грязный, грязно и всё его поддерево: чистым узел становится
+// только вместе со всеми предками (resolve), потомков это не касается
+void SceneGraph::markDirty(uint32_t slot) {
+    if (dirty[slot]) {
+        return;
+    }
+    std::fill(dirty.begin() + slot, dirty.begin() + slot + subtreeSizes[slot], uint8_t(1));
+    firstDirty = std::min(firstDirty, size_t(slot));
+}
+
+const glm::mat4& SceneGraph::resolve(uint32_t slot) {
+    if (dirty[slot]) {
+        uint32_t parent = parents[slot];
+        worlds[slot] = parent == INVALID ? locals[slot] : resolve(parent) * locals[slot];
+        dirty[slot] = 0;
+    }
+    return worlds[slot];
+}
+
+size_t SceneGraph::update() {
+    // Родитель стоит раньше детей, поэтому к моменту пересчёта ребёнка он уже чистый
+    size_t updated = 0;
+    for (size_t i = firstDirty; i < nodeAt.size(); ++i) {
+        if (!dirty[i]) {
+            continue;
+        }
+        uint32_t parent = parents[i];
+        worlds[i] = parent == INVALID ? locals[i] : worlds[parent] * locals[i];
+        dirty[i] = 0;
+        ++updated;
+    }
+    firstDirty = nodeAt.size();
+    return updated;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+// Иерархия трансформаций (граф сцены).
+// - Узел хранит локальную матрицу относительно родителя; мировая матрица
+//   считается лениво: только у узлов, чей родитель (или они сами) сдвинулся.
+// - Узлы лежат в массивах в порядке обхода в глубину: родитель всегда раньше
+//   детей, поддерево — непрерывный отрезок. Поэтому update() пересчитывает все
+//   грязные узлы одним линейным проходом, а пометка поддерева — заполнение отрезка.
+// - Снаружи узлы адресуются стабильными идентификаторами NodeId; при вставке
+//   и удалении меняются только позиции в массивах.
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SceneGraph {
+public:
+    using NodeId = uint32_t;
+    static constexpr NodeId INVALID = UINT32_MAX;
+
+    // Вставка и удаление узлов не обращаются к куче, пока узлов не больше count
+    void reserve(size_t count);
+
+    // Новый узел последним ребёнком parent (INVALID — корень)
+    NodeId create(NodeId parent = INVALID, const glm::mat4& local = glm::mat4(1.0f));
+    // Удаляет узел вместе со всеми потомками
+    void destroy(NodeId node);
+
+    // Помечает поддерево грязным, только если матрица действительно изменилась
+    void setLocal(NodeId node, const glm::mat4& local);
+    const glm::mat4& local(NodeId node) const { return locals[slotOf[node]]; }
+
+    // Мировая матрица; если узел грязный — пересчитывается цепочка от ближайшего чистого предка
+    const glm::mat4& world(NodeId node) { return resolve(slotOf[node]); }
+    glm::vec3 worldPosition(NodeId node) { return glm::vec3(world(node)[3]); }
+    // Узлы смотрят вдоль своей оси -Z (как камера OpenGL)
+    glm::vec3 worldForward(NodeId node) { return -glm::normalize(glm::vec3(world(node)[2])); }
+
+    // Пересчёт всех грязных узлов одним проходом по массиву. Возвращает, сколько пересчитано
+    size_t update();
+
+    size_t size() const { return nodeAt.size(); }
+    bool isAlive(NodeId node) const { return node < slotOf.size() && slotOf[node] != INVALID; }
+
+private:
+    // Массивы в порядке обхода в глубину (индекс — позиция узла)
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint32_t> parents;        // Позиция родителя или INVALID
+    std::vector<uint32_t> subtreeSizes;   // Размер поддерева вместе с самим узлом
+    std::vector<uint8_t> dirty;
+    std::vector<NodeId> nodeAt;
+
+    std::vector<uint32_t> slotOf;         // NodeId -> позиция
+    std::vector<NodeId> freeIds;
+    size_t firstDirty = 0;                // Раньше этой позиции грязных узлов нет
+
+    const glm::mat4& resolve(uint32_t slot);
+    void markDirty(uint32_t slot);
+    // После вставки или удаления: обновить позиции узлов начиная с from
+    // и сдвинуть на delta ссылки на родителей, стоящих не раньше threshold
+    void reindex(uint32_t from, uint32_t threshold, int delta);
+};
@@ -0,0 +1,622 @@
+#include "simulation.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+// Аналог rand() % range, но из генератора мира
+int randomInt(World& world, int range) {
+    return static_cast<int>(world.rng() % static_cast<uint32_t>(range));
+}
+
+// Локальная матрица узла в точке offset, смотрящего вдоль direction (его ось -Z)
+glm::mat4 lookAlong(const glm::vec3& offset, const glm::vec3& direction) {
+    return glm::inverse(glm::lookAt(offset, offset + direction, glm::vec3(0.0f, 1.0f, 0.0f)));
+}
+
+AirshipRig createAirshipRig(SceneGraph& scene, const Light& light) {
+    AirshipRig rig;
+    rig.root = scene.create();
+    rig.hull = scene.create(rig.root);
+    // Камера сзади сверху смотрит по курсу, камера прицеливания — из-под гондолы вперёд и вниз
+    rig.followCamera = scene.create(rig.root, lookAlong(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+    rig.aimCamera = scene.create(rig.root, lookAlong(glm::vec3(0.0f, -1.5f, -1.0f), glm::vec3(0.0f, -0.8f, 1.0f)));
+    rig.spotlight = scene.create(rig.root, lookAlong(light.offset, light.direction));
+    rig.releasePoint = scene.create(rig.root, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -2.0f, 0.0f)));
+    // Груз висит на корпусе за камерой прицеливания и качается вместе с ним
+    glm::mat4 cargo = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.8f, -2.5f));
+    rig.cargo = scene.create(rig.hull, glm::scale(cargo, glm::vec3(0.6f)));
+    return rig;
+}
+
+void syncAirshipRig(SceneGraph& scene, const Transform& transform, const AirshipRig& rig) {
+    glm::mat4 root = glm::translate(glm::mat4(1.0f), transform.position);
+    scene.setLocal(rig.root, glm::rotate(root, transform.yaw, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+    glm::mat4 hull = glm::rotate(glm::mat4(1.0f), transform.pitch, glm::vec3(1.0f, 0.0f, 0.0f));
+    hull = glm::rotate(hull, transform.roll, glm::vec3(0.0f, 0.0f, 1.0f));
+    scene.setLocal(rig.hull, glm::scale(hull, transform.scale));
+}
+
+void initClouds(World& world, int count) {
+    for (int i = 0; i < count; ++i) {
+        Transform transform;
+        transform.position = glm::vec3(
+            (randomInt(world, 200) - 100),
+            30.0f + randomInt(world, 20),
+            (randomInt(world, 200) - 100)
+        );
+        transform.scale = glm::vec3(3.0f, 2.0f, 3.0f);
+
+        Motion motion;
+        motion.velocity = glm::vec3(
+            (randomInt(world, 100) - 50) * 0.01f,
+            0.0f,
+            (randomInt(world, 100) - 50) * 0.01f
+        );
+        motion.oscillation = randomInt(world, 100) * 0.01f * glm::pi<float>();
+
+        StormCloud cloud;
+        cloud.flashDuration = 2.0f + randomInt(world, 100) * 0.01f;
+
+        ecs::Entity entity = world.registry.create();
+        world.registry.add(entity, transform);
+        world.registry.add(entity, motion);
+        world.registry.add(entity, cloud);
+        world.registry.add(entity, RainEmitter());
+        world.registry.add(entity, Renderable{MODEL_CLOUD, MATERIAL_CLOUD, modelColor(MODEL_CLOUD)});
+    }
+}
+
+void initBalloons(World& world, int count) {
+    for (int i = 0; i < count; ++i) {
+        Transform transform;
+        transform.position = glm::vec3(
+            (randomInt(world, 180) - 90),
+            10.0f + randomInt(world, 20),
+            (randomInt(world, 180) - 90)
+        );
+        glm::vec3 color = glm::vec3(
+            randomInt(world, 100) * 0.01f,
+            randomInt(world, 100) * 0.01f,
+            randomInt(world, 100) * 0.01f
+        );
+
+        ecs::Entity entity = world.registry.create();
+        world.registry.add(entity, transform);
+        world.registry.add(entity, Motion());
+        world.registry.add(entity, Hover{transform.position.y, 0.5f});
+        world.registry.add(entity, Renderable{MODEL_BALLOON, MATERIAL_LIT, color});
+    }
+}
+
+void initTargets(World& world, int count) {
+    for (int i = 0; i < count; ++i) {
+        Transform transform;
+        transform.position = glm::vec3(
+            (randomInt(world, 160) - 80),
+            0.0f,
+            (randomInt(world, 160) - 80)
+        );
+
+        ecs::Entity entity = world.registry.create();
+        world.registry.add(entity, transform);
+        world.registry.add(entity, Target());
+        world.registry.add(entity, Renderable{MODEL_TARGET, MATERIAL_LIT, modelColor(MODEL_TARGET)});
+    }
+}
+
+void applyInput(World& world, const InputState& input, float deltaTime) {
+    ecs::Registry& registry = world.registry;
+    ecs::Entity player = world.playerAirship;
+
+    if (input.toggleSpotlight) {
+        Light& spotlight = registry.get<Light>(player);
+        spotlight.on = !spotlight.on;
+    }
+    if (input.dropParcel && dropParcel(world, player)) {
+        registry.get<PlayerControl>(player).parcelsDropped++;
+    }
+    if (input.toggleAutopilot) {
+        Autopilot& pilot = registry.get<Autopilot>(player);
+        pilot.active = !pilot.active;
+    }
+
+    // Под автопилотом ручное управление отключено
+    if (registry.get<Autopilot>(player).active) {
+        return;
+    }
+
+    Transform& airship = registry.get<Transform>(player);
+    const Airship& params = registry.get<Airship>(player);
+    airship.position += glm::clamp(input.move, glm::vec3(-1.0f), glm::vec3(1.0f)) * params.speed * deltaTime;
+    airship.yaw += glm::clamp(input.turn, -1.0f, 1.0f) * params.turnSpeed * deltaTime;
+}
+
+void updateClouds(World& world, float deltaTime) {
+    float time = world.timeElapsed;
+    world.registry.each<Transform, Motion, StormCloud>([&world, time, deltaTime](Transform& transform, Motion& motion, StormCloud& cloud) {
+        // Движение по тригонометрической траектории
+        // Скорость сохраняем — по ней планировщик предсказывает положение тучи
+        motion.velocity = glm::vec3(
+            sin(time + motion.oscillation) * 0.5f,
+            sin(time * 0.7f + motion.oscillation * 2.0f) * 0.2f,
+            cos(time + motion.oscillation) * 0.5f
+        );
+        transform.position += motion.velocity * deltaTime;
+
+        motion.oscillation += 0.1f * deltaTime;
+
+        // Мерцание
+        cloud.flashTimer += deltaTime;
+        if (cloud.flashTimer >= cloud.flashDuration) {
+            cloud.isFlashing = true;
+            cloud.flashTimer = 0.0f;
+            cloud.flashDuration = 0.1f + randomInt(world, 100) * 0.001f;
+        } else if (cloud.isFlashing && cloud.flashTimer > 0.05f) {
+            cloud.isFlashing = false;
+            cloud.flashDuration = 3.0f + randomInt(world, 100) * 0.1f;
+        }
+    });
+}
+
+void updateBalloons(World& world, float deltaTime) {
+    world.registry.each<Transform, Motion, Hover>([deltaTime](Transform& transform, Motion& motion, const Hover& hover) {
+        motion.oscillation += deltaTime;
+        // Легкое покачивание
+        transform.position.y = hover.baseHeight + sin(motion.oscillation) * hover.amplitude;
+    });
+}
+
+void updateAirships(World& world) {
+    // Легкое покачивание корпуса
+    float pitch = float(sin(world.timeElapsed) * 0.02f);
+    float roll = float(cos(world.timeElapsed * 1.3f) * 0.02f);
+
+    world.registry.each<Transform, Airship>([pitch, roll](Transform& transform, const Airship&) {
+        transform.pitch = pitch;
+        transform.roll = roll;
+    });
+}
+
+void updateParcels(World& world, float deltaTime) {
+    ecs::Registry& registry = world.registry;
+    registry.each<Transform, Motion, Parcel>([&](ecs::Entity entity, Transform& transform, Motion& motion, const Parcel&) {
+        motion.velocity.y -= GRAVITY * deltaTime;
+        transform.position += motion.velocity * deltaTime;
+        transform.yaw += deltaTime;
+
+        if (transform.position.y > 0.5f) {
+            return;
+        }
+
+        // Посылка упала — проверяем, попала ли она в мишень
+        bool delivered = false;
+        registry.each<Transform, Target>([&](const Transform& targetTransform, Target& target) {
+            glm::vec3 delta = transform.position - targetTransform.position;
+            delta.y = 0.0f;
+            if (glm::length(delta) <= target.radius) {
+                target.deliveries++;
+                delivered = true;
+            }
+        });
+        // Посылка считается один раз, даже если мишени перекрываются
+        if (delivered) {
+            world.stats.deliveries++;
+        } else {
+            world.stats.parcelsMissed++;
+        }
+        world.commands.despawn(entity);
+    });
+}
+
+// Влёт в тучу: дирижабль внутри эллипсоида модели тучи (сфера радиусом 3, растянутая масштабом)
+void countCloudEncounters(World& world) {
+    ecs::Registry& registry = world.registry;
+    registry.each<Transform, Airship>([&](const Transform& transform, Airship& airship) {
+        bool inside = false;
+        registry.each<Transform, StormCloud>([&](const Transform& cloudTransform, const StormCloud&) {
+            glm::vec3 local = (transform.position - cloudTransform.position) / (cloudTransform.scale * 3.0f);
+            inside = inside || glm::dot(local, local) < 1.0f;
+        });
+        if (inside && !airship.insideCloud) {
+            world.stats.cloudEncounters++;
+        }
+        airship.insideCloud = inside;
+    });
+}
+
+// Раз в PLAN_INTERVAL отправляем планировщику снимок: дирижабли, цели и препятствия.
+// Если предыдущий запрос ещё считается, шаг не ждёт — попробуем в следующий раз.
+void schedulePlanning(World& world, float deltaTime) {
+    world.planTimer += deltaTime;
+    if (world.planTimer < PLAN_INTERVAL || world.routePlanner->busy()) {
+        return;
+    }
+    world.planTimer = 0.0f;
+
+    // Буферы прошлого запроса очищаем, но не освобождаем
+    planner::PlanRequest& request = world.planRequest;
+    request.airships.clear();
+    request.targets.clear();
+    request.obstacles.clear();
+    request.reassignTargets = false;
+    bool needTours = false;
+
+    ecs::Registry& registry = world.registry;
+    registry.each<Transform, Autopilot>([&](const Transform& transform, const Autopilot& pilot) {
+        if (!pilot.active) {
+            return;
+        }
+        const AutopilotRoute& route = world.autopilotRoutes[pilot.route];
+        planner::AirshipState state = {pilot.route, transform.position, glm::vec3(0.0f), false};
+        if (route.nextTarget < route.tour.size()) {
+            state.goal = dropPointAbove(world, route.tour[route.nextTarget]);
+            state.hasGoal = true;
+        } else {
+            needTours = true;
+        }
+        request.airships.push_back(state);
+    });
+
+    if (request.airships.empty()) {
+        return;
+    }
+
+    // Кто-то облетел все цели — раздаём новый круг доставок всем дирижаблям
+    if (needTours) {
+        request.reassignTargets = true;
+        world.plannedTargets.clear();
+        registry.each<Transform, Target>([&](ecs::Entity entity, const Transform& transform, const Target&) {
+            world.plannedTargets.push_back(entity);
+            request.targets.push_back(transform.position);
+        });
+    }
+
+    // Тучи: сфера модели радиусом 3, растянутая масштабом
+    registry.each<Transform, Motion, StormCloud>([&](const Transform& transform, const Motion& motion, const StormCloud&) {
+        request.obstacles.push_back({transform.position, motion.velocity, transform.scale * 3.0f});
+    });
+
+    // Воздушные шары висят на месте
+    registry.each<Transform, Hover>([&](const Transform& transform, const Hover& hover) {
+        glm::vec3 center = transform.position + glm::vec3(0.0f, 1.5f, 0.0f);
+        request.obstacles.push_back({center, glm::vec3(0.0f), glm::vec3(1.5f, 1.5f + hover.amplitude, 1.5f)});
+    });
+
+    world.routePlanner->submit(request);
+    if (world.synchronousPlanning) {
+        world.routePlanner->wait();
+    }
+}
+
+void applyPlans(World& world) {
+    planner::PlanResult& result = world.planResult;
+    if (!world.routePlanner->poll(result)) {
+        return;
+    }
+    world.stats.plansApplied++;
+    world.stats.planningMilliseconds += result.gridMilliseconds + result.tourMilliseconds + result.pathMilliseconds;
+
+    for (auto& plan : result.airships) {
+        AutopilotRoute& route = world.autopilotRoutes[plan.id];
+
+        if (result.toursUpdated) {
+            route.tour.clear();
+            for (int index : plan.tour) {
+                route.tour.push_back(world.plannedTargets[index]);
+            }
+            route.nextTarget = 0;
+            route.path.clear();
+        }
+
+        // Пока план считался, дирижабль мог уже сбросить посылку и сменить цель
+        bool sameGoal = route.nextTarget < route.tour.size()
+            && !plan.path.empty()
+            && plan.path.back() == dropPointAbove(world, route.tour[route.nextTarget]);
+        if (sameGoal) {
+            // Обмен, а не перемещение: старый буфер пути вернётся планировщику
+            std::swap(route.path, plan.path);
+            route.nextWaypoint = 1;
+        }
+    }
+}
+
+void updateAutopilot(World& world, float deltaTime) {
+    ecs::Registry& registry = world.registry;
+    registry.each<Transform, Airship, Autopilot>([&](ecs::Entity entity, Transform& transform, const Airship& airship, const Autopilot& pilot) {
+        if (!pilot.active) {
+            return;
+        }
+        AutopilotRoute& route = world.autopilotRoutes[pilot.route];
+        if (route.nextTarget >= route.tour.size()) {
+            return;
+        }
+
+        ecs::Entity target = route.tour[route.nextTarget];
+        if (!registry.isAlive(target)) {
+            route.nextTarget++;
+            route.path.clear();
+            return;
+        }
+
+        // Над целью — сбрасываем посылку и берём следующую
+        glm::vec3 goal = dropPointAbove(world, target);
+        glm::vec3 toGoal = goal - transform.position;
+        if (glm::length(glm::vec3(toGoal.x, 0.0f, toGoal.z)) < 1.5f) {
+            dropParcel(world, entity);
+            route.nextTarget++;
+            route.path.clear();
+            return;
+        }
+
+        // Без пути в обход туч не летим — ждём ответа планировщика
+        if (route.nextWaypoint >= route.path.size()) {
+            return;
+        }
+        glm::vec3 toWaypoint = route.path[route.nextWaypoint] - transform.position;
+        float distance = glm::length(toWaypoint);
+        if (distance < 0.5f) {
+            route.nextWaypoint++;
+            return;
+        }
+
+        glm::vec3 direction = toWaypoint / distance;
+        transform.position += direction * std::min(airship.speed * deltaTime, distance);
+        if (std::abs(direction.x) + std::abs(direction.z) > 0.01f) {
+            transform.yaw = atan2(direction.x, direction.z);
+        }
+    });
+}
+
+} // namespace
+
+glm::vec3 modelColor(ModelId model) {
+    switch (model) {
+        case MODEL_GROUND:  return glm::vec3(0.2f, 0.6f, 0.3f);
+        case MODEL_TREE:    return glm::vec3(0.0f, 0.5f, 0.0f);
+        case MODEL_AIRSHIP: return glm::vec3(0.8f, 0.2f, 0.2f);
+        case MODEL_CLOUD:   return glm::vec3(0.7f, 0.7f, 0.7f);  // БЫЛО: (0.9f, 0.9f, 0.9f) - ТЕМНЕЕ
+        case MODEL_BALLOON: return glm::vec3(1.0f, 0.0f, 0.0f);
+        case MODEL_TARGET:  return glm::vec3(1.0f);   // Красно-белый узор — в вершинах модели
+        case MODEL_PARCEL:  return glm::vec3(0.6f, 0.4f, 0.2f);
+        default:            return glm::vec3(1.0f);
+    }
+}
+
+void initWorld(World& world, const WorldSettings& settings) {
+    world.rng.seed(settings.seed);
+    world.synchronousPlanning = settings.synchronousPlanning;
+
+    // Память под сущности, посылки и команды выделяется заранее,
+    // чтобы шаг мира не обращался к куче. MAX_ENTITIES — нижняя граница: мир
+    // с сотнями тысяч шаров (пакетный прогон --balloons 100000) резервируется по факту
+    size_t sceneEntities = 2 + size_t(settings.cloudCount) + size_t(settings.balloonCount) + size_t(settings.targetCount);
+    world.targetCapacity = std::max(MAX_ENTITIES, size_t(settings.targetCount));
+    world.registry.reserve(std::max(MAX_ENTITIES, sceneEntities + MAX_AIRSHIPS + MAX_PARCELS));
+    world.registry.reserveArchetype<Transform, Motion, Hover, Renderable>(settings.balloonCount);
+    world.registry.reserveArchetype<Transform, Motion, Parcel, Renderable>(MAX_PARCELS);
+    world.registry.count<Parcel>();   // Кэш запроса для dropParcel — сейчас, а не при первом сбросе
+    world.commands.reserve(MAX_PARCELS * 256, MAX_PARCELS);
+    world.plannedTargets.reserve(world.targetCapacity);
+
+    // Поле
+    ecs::Entity ground = world.registry.create();
+    world.registry.add(ground, Transform());
+    world.registry.add(ground, Renderable{MODEL_GROUND, MATERIAL_LIT, modelColor(MODEL_GROUND)});
+
+    // Ёлка
+    ecs::Entity tree = world.registry.create();
+    world.registry.add(tree, Transform());
+    world.registry.add(tree, Renderable{MODEL_TREE, MATERIAL_LIT, modelColor(MODEL_TREE)});
+
+    initClouds(world, settings.cloudCount);
+    initBalloons(world, settings.balloonCount);
+    initTargets(world, settings.targetCount);
+
+    world.playerAirship = spawnAirship(world, glm::vec3(0.0f, 15.0f, 0.0f), 0.0f, true);
+    world.registry.get<Autopilot>(world.playerAirship).active = settings.playerAutopilot;
+
+    for (int i = 0; i < settings.fleetSize; ++i) {
+        glm::vec3 position(randomInt(world, 160) - 80, CRUISE_ALTITUDE, randomInt(world, 160) - 80);
+        ecs::Entity airship = spawnAirship(world, position, 0.0f, false);
+        if (world.registry.has<Autopilot>(airship)) {
+            world.registry.get<Autopilot>(airship).active = true;
+        }
+    }
+
+    planner::PlanCapacity planCapacity;
+    planCapacity.airships = MAX_AIRSHIPS;
+    planCapacity.targets = world.targetCapacity;
+    planCapacity.obstacles = std::max(MAX_ENTITIES, size_t(settings.cloudCount) + size_t(settings.balloonCount));
+    planCapacity.pathLength = ROUTE_CAPACITY;
+    planner::reserve(world.planRequest, planCapacity);
+    planner::reserve(world.planResult, planCapacity);
+    world.routePlanner.reset(new planner::RoutePlanner(planner::GridSettings(), settings.plannerThreads, planCapacity));
+}
+
+void stepWorld(World& world, const InputState& input, float deltaTime) {
+    world.timeElapsed += deltaTime;
+
+    applyInput(world, input, deltaTime);
+
+    // Автопилот: забираем готовые маршруты и летим по ним
+    applyPlans(world);
+    updateAutopilot(world, deltaTime);
+
+    updateClouds(world, deltaTime);
+    updateBalloons(world, deltaTime);
+    updateAirships(world);
+    updateParcels(world, deltaTime);
+    countCloudEncounters(world);
+
+    // Спавн и удаление сущностей, накопленные за шаг
+    world.commands.flush(world.registry);
+    world.parcelsSpawning = 0;
+
+    schedulePlanning(world, deltaTime);
+    syncAirshipRigs(world);
+}
+
+void syncAirshipRigs(World& world) {
+    SceneGraph& scene = world.scene;
+    world.registry.each<Transform, AirshipRig>([&scene](const Transform& transform, const AirshipRig& rig) {
+        syncAirshipRig(scene, transform, rig);
+    });
+}
+
+ecs::Entity spawnAirship(World& world, const glm::vec3& position, float yaw, bool player) {
+    Transform transform;
+    transform.position = position;
+    transform.yaw = yaw;
+
+    ecs::Registry& registry = world.registry;
+    ecs::Entity entity = registry.create();
+    registry.add(entity, transform);
+    registry.add(entity, Airship());
+    registry.add(entity, Light());
+    AirshipRig rig = createAirshipRig(world.scene, registry.get<Light>(entity));
+    syncAirshipRig(world.scene, transform, rig);
+    registry.add(entity, rig);
+    registry.add(entity, Renderable{MODEL_AIRSHIP, MATERIAL_LIT, modelColor(MODEL_AIRSHIP)});
+    uint32_t routeIndex = world.autopilotRoutes.acquire();
+    if (routeIndex == Pool<AutopilotRoute>::INVALID) {
+        std::cerr << "Autopilot route pool exhausted" << std::endl;
+    } else {
+        AutopilotRoute& route = world.autopilotRoutes[routeIndex];
+        route = AutopilotRoute();
+        route.tour.reserve(world.targetCapacity);
+        route.path.reserve(ROUTE_CAPACITY);
+        registry.add(entity, Autopilot{routeIndex, false});
+    }
+    if (player) {
+        registry.add(entity, PlayerControl());
+    }
+    return entity;
+}
+
+bool dropParcel(World& world, ecs::Entity airship) {
+    // Архетип посылок зарезервирован на MAX_PARCELS строк и работает как пул фиксированной
+    // ёмкости: строки освобождаются обменом с последней, индексы сущностей переиспользуются.
+    // Сверх ёмкости не сбрасываем — иначе массив вырастет посреди игры
+    if (world.registry.count<Parcel>() + world.parcelsSpawning >= MAX_PARCELS) {
+        return false;
+    }
+    ++world.parcelsSpawning;
+
+    const Transform& source = world.registry.get<Transform>(airship);
+    const AirshipRig& rig = world.registry.get<AirshipRig>(airship);
+    // Дирижабль мог сдвинуться в этом же шаге — узлы подтягиваются до чтения точки сброса
+    syncAirshipRig(world.scene, source, rig);
+
+    Transform transform;
+    transform.position = world.scene.worldPosition(rig.releasePoint);
+    transform.yaw = source.yaw;
+
+    ecs::Entity parcel = world.commands.spawn(world.registry);
+    world.commands.add(parcel, transform);
+    world.commands.add(parcel, Motion());
+    world.commands.add(parcel, Parcel{airship});
+    world.commands.add(parcel, Renderable{MODEL_PARCEL, MATERIAL_LIT, modelColor(MODEL_PARCEL)});
+    world.stats.parcelsDropped++;
+    return true;
+}
+
+glm::vec3 dropPointAbove(World& world, ecs::Entity target) {
+    glm::vec3 position = world.registry.get<Transform>(target).position;
+    return glm::vec3(position.x, CRUISE_ALTITUDE, position.z);
+}
+
+// ---------------------------------------------------------------------------
+// Ввод по сценарию
+// ---------------------------------------------------------------------------
+
+bool InputScript::load(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    commands.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream stream(line);
+        Command command = {0.0f, ACTION_DROP, glm::vec3(0.0f)};
+        std::string name;
+        if (!(stream >> command.time)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            error = path + ":" + std::to_string(lineNumber) + ": expected time";
+            return false;
+        }
+        stream >> name;
+
+        bool valid = true;
+        if (name == "move") {
+            command.action = ACTION_MOVE;
+            valid = static_cast<bool>(stream >> command.value.x >> command.value.y >> command.value.z);
+        } else if (name == "turn") {
+            command.action = ACTION_TURN;
+            valid = static_cast<bool>(stream >> command.value.x);
+        } else if (name == "drop") {
+            command.action = ACTION_DROP;
+        } else if (name == "autopilot") {
+            command.action = ACTION_AUTOPILOT;
+        } else if (name == "spotlight") {
+            command.action = ACTION_SPOTLIGHT;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            error = path + ":" + std::to_string(lineNumber) + ": bad command '" + name + "'";
+            return false;
+        }
+        commands.push_back(command);
+    }
+
+    // Порядок команд с одинаковым временем сохраняется
+    std::stable_sort(commands.begin(), commands.end(), [](const Command& a, const Command& b) {
+        return a.time < b.time;
+    });
+    rewind();
+    return true;
+}
+
+InputState InputScript::next(float time) {
+    InputState input;
+    for (; cursor < commands.size() && commands[cursor].time <= time; ++cursor) {
+        const Command& command = commands[cursor];
+        switch (command.action) {
+            case ACTION_MOVE:      heldMove = command.value; break;
+            case ACTION_TURN:      heldTurn = command.value.x; break;
+            case ACTION_DROP:      input.dropParcel = true; break;
+            case ACTION_AUTOPILOT: input.toggleAutopilot = !input.toggleAutopilot; break;
+            case ACTION_SPOTLIGHT: input.toggleSpotlight = !input.toggleSpotlight; break;
+        }
+    }
+    input.move = heldMove;
+    input.turn = heldTurn;
+    return input;
+}
+
+void InputScript::rewind() {
+    cursor = 0;
+    heldMove = glm::vec3(0.0f);
+    heldTurn = 0.0f;
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+// Игровая логика без окна и OpenGL: компоненты сцены, автопилот и шаг мира.
+// - Всё состояние — в World, поэтому миров может быть сколько угодно, каждый
+//   со своим генератором случайных чисел (std::mt19937 с заданным зерном).
+// - Ввод приходит структурой InputState: из клавиатуры (main.cpp), из сценария
+//   (InputScript) или из программы, которая гоняет миры пачкой (batch.cpp).
+// - Всё, что закреплено на дирижабле (камеры, прожектор, точка сброса, груз),
+//   — узлы иерархии World::scene под узлом дирижабля (AirshipRig).
+
+#include "ecs.h"
+#include "memory.h"
+#include "planner.h"
+#include "scene.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+enum ModelId {
+    MODEL_GROUND,
+    MODEL_TREE,
+    MODEL_AIRSHIP,
+    MODEL_CLOUD,
+    MODEL_BALLOON,
+    MODEL_TARGET,
+    MODEL_PARCEL,
+    MODEL_COUNT
+};
+
+enum Material {
+    MATERIAL_LIT,     // Основной шейдер с освещением
+    MATERIAL_CLOUD    // Полупрозрачные тучи
+};
+
+// Основной цвет каждой модели (шары перекрашиваются случайно)
+glm::vec3 modelColor(ModelId model);
+
+// Компоненты ECS
+struct Transform {
+    glm::vec3 position = glm::vec3(0.0f);
+    float yaw = 0.0f;
+    float pitch = 0.0f;
+    float roll = 0.0f;
+    glm::vec3 scale = glm::vec3(1.0f);
+};
+
+struct Motion {
+    glm::vec3 velocity = glm::vec3(0.0f);
+    float oscillation = 0.0f;
+};
+
+struct Renderable {
+    ModelId model = MODEL_GROUND;
+    Material material = MATERIAL_LIT;
+    glm::vec3 color = glm::vec3(1.0f);
+};
+
+// Прожектор, закреплённый за сущностью (смещение и направление в её локальных координатах)
+struct Light {
+    glm::vec3 offset = glm::vec3(0.0f, -1.5f, -2.0f);
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.2f);
+    glm::vec3 color = glm::vec3(1.0f, 1.0f, 0.9f);  // Теплый белый свет
+    float intensity = 4.0f;                          // Кадр в HDR — в центре пятна ярче белого
+    float cutoff = 15.0f;                            // Внутренний угол, градусы
+    float outerCutoff = 25.0f;                       // Внешний угол, градусы
+    bool on = false;
+};
+
+struct StormCloud {
+    float flashTimer = 0.0f;
+    float flashDuration = 2.0f;
+    bool isFlashing = false;
+};
+
+// Дождь и искры под тучей (сами частицы живут на видеокарте)
+struct RainEmitter {
+    float sparkChance = 0.03f;
+};
+
+struct Hover {
+    float baseHeight = 0.0f;
+    float amplitude = 0.5f;
+};
+
+struct Airship {
+    float speed = 15.0f;
+    float turnSpeed = 1.5f;
+    bool insideCloud = false;   // Для подсчёта влётов в тучи
+};
+
+// Узлы дирижабля в World::scene. root — положение и курс, к нему крепится всё остальное;
+// корпус покачивается отдельно, чтобы камеры и прожектор не качались вместе с ним.
+// Камеры и прожектор смотрят вдоль своей оси -Z
+struct AirshipRig {
+    SceneGraph::NodeId root = SceneGraph::INVALID;
+    SceneGraph::NodeId hull = SceneGraph::INVALID;          // По нему рисуется модель
+    SceneGraph::NodeId followCamera = SceneGraph::INVALID;
+    SceneGraph::NodeId aimCamera = SceneGraph::INVALID;
+    SceneGraph::NodeId spotlight = SceneGraph::INVALID;
+    SceneGraph::NodeId releasePoint = SceneGraph::INVALID;  // Откуда падают посылки
+    SceneGraph::NodeId cargo = SceneGraph::INVALID;         // Посылка, подвешенная под корпусом
+};
+
+struct PlayerControl {
+    int parcelsDropped = 0;
+};
+
+struct Parcel {
+    ecs::Entity owner = ecs::NULL_ENTITY;
+};
+
+struct Target {
+    float radius = 4.0f;
+    int deliveries = 0;
+};
+
+// Автопилот: маршрут хранится вне компонента (в пуле World::autopilotRoutes), сам компонент — только индекс
+struct Autopilot {
+    uint32_t route = 0;
+    bool active = false;
+};
+
+struct AutopilotRoute {
+    std::vector<ecs::Entity> tour;      // Порядок облёта целей
+    size_t nextTarget = 0;
+    std::vector<glm::vec3> path;        // Путь в обход туч до текущей цели
+    size_t nextWaypoint = 0;
+};
+
+const float GRAVITY = 9.8f;
+const float CRUISE_ALTITUDE = 32.0f;    // Высота полёта автопилота (на уровне туч)
+const float PLAN_INTERVAL = 0.25f;      // Как часто отправлять снимок сцены планировщику
+const size_t MAX_AIRSHIPS = 16;
+const size_t MAX_ENTITIES = 1024;
+const size_t MAX_PARCELS = 256;         // Посылок в воздухе одновременно
+const size_t ROUTE_CAPACITY = 64;       // Точек пути на дирижабль без перевыделения
+const size_t AIRSHIP_RIG_NODES = 7;     // Узлов иерархии на дирижабль
+
+// Управление дирижаблем игрока за один шаг
+struct InputState {
+    glm::vec3 move = glm::vec3(0.0f);   // -1..1 по осям мира (y — вверх)
+    float turn = 0.0f;                  // +1 — влево, -1 — вправо
+    // Разовые действия (нажатие клавиши)
+    bool dropParcel = false;
+    bool toggleAutopilot = false;
+    bool toggleSpotlight = false;
+};
+
+struct WorldSettings {
+    uint32_t seed = 1;
+    int fleetSize = 3;                  // Дирижабли под управлением автопилота
+    int cloudCount = 8;
+    int balloonCount = 10;
+    int targetCount = 12;
+    bool playerAutopilot = false;
+    unsigned plannerThreads = 0;        // 0 — по числу ядер
+    // Ждать ответ планировщика в том же шаге: маршрут применяется строго на следующем,
+    // и прогон не зависит от скорости машины (для пакетных прогонов)
+    bool synchronousPlanning = false;
+};
+
+struct WorldStats {
+    int deliveries = 0;
+    int parcelsDropped = 0;
+    int parcelsMissed = 0;
+    int cloudEncounters = 0;            // Сколько раз дирижабли влетали в тучи
+    int plansApplied = 0;
+    double planningMilliseconds = 0.0;  // Время планировщика: сетка, туры и пути
+};
+
+struct World {
+    World() : autopilotRoutes(MAX_AIRSHIPS) { scene.reserve(MAX_AIRSHIPS * AIRSHIP_RIG_NODES); }
+
+    ecs::Registry registry;
+    ecs::CommandBuffer commands;
+    ecs::Entity playerAirship = ecs::NULL_ENTITY;
+    SceneGraph scene;
+
+    Pool<AutopilotRoute> autopilotRoutes;
+    std::unique_ptr<planner::RoutePlanner> routePlanner;
+    std::vector<ecs::Entity> plannedTargets;   // Цели в том порядке, в каком ушли в планировщик
+    size_t targetCapacity = MAX_ENTITIES;      // Ёмкость списков целей (туры, запрос планировщику)
+    size_t parcelsSpawning = 0;                // Посылки этого шага, ещё не попавшие в реестр
+    // Буферы обмена с планировщиком: переходят туда и обратно, сохраняя ёмкость
+    planner::PlanRequest planRequest;
+    planner::PlanResult planResult;
+    float planTimer = 0.0f;
+    bool synchronousPlanning = false;
+
+    float timeElapsed = 0.0f;
+    std::mt19937 rng;
+    WorldStats stats;
+};
+
+// Расставляет сцену и запускает планировщик. Мир нельзя инициализировать повторно
+void initWorld(World& world, const WorldSettings& settings);
+void stepWorld(World& world, const InputState& input, float deltaTime);
+
+ecs::Entity spawnAirship(World& world, const glm::vec3& position, float yaw, bool player);
+// Переносит Transform дирижаблей в локальные матрицы их узлов (вызывается в конце stepWorld)
+void syncAirshipRigs(World& world);
+// Сброс посылки из-под дирижабля. Посылка появится в конце шага (после commands.flush()).
+// false — в воздухе уже MAX_PARCELS посылок
+bool dropParcel(World& world, ecs::Entity airship);
+// Точка сброса над целью
+glm::vec3 dropPointAbove(World& world, ecs::Entity target);
+
+// Ввод по сценарию: текстовый файл, строка — «время команда [аргументы]».
+//   0.0  move 0 0 -1    лететь вперёд, пока не придёт другая команда move
+//   1.5  turn 1         поворачивать влево (turn 0 — прямо)
+//   2.0  drop           сбросить посылку
+//   2.0  autopilot      включить/выключить автопилот
+//   3.0  spotlight      включить/выключить прожектор
+// Пустые строки и строки с # пропускаются
+class InputScript {
+public:
+    bool load(const std::string& path, std::string& error);
+    // Ввод на шаг, который закончится во время time. Команды выполняются по порядку
+    InputState next(float time);
+    void rewind();
+
+    bool empty() const { return commands.empty(); }
+
+private:
+    enum Action {
+        ACTION_MOVE,
+        ACTION_TURN,
+        ACTION_DROP,
+        ACTION_AUTOPILOT,
+        ACTION_SPOTLIGHT
+    };
+
+    struct Command {
+        float time;
+        Action action;
+        glm::vec3 value;
+    };
+
+    std::vector<Command> commands;
+    size_t cursor = 0;
+    glm::vec3 heldMove = glm::vec3(0.0f);
+    float heldTurn = 0.0f;
+};
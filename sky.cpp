@@ -0,0 +1,661 @@
+#include "sky.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// Размеры таблиц
+const int TRANSMITTANCE_WIDTH = 256;
+const int TRANSMITTANCE_HEIGHT = 64;
+const int MULTI_SCATTERING_SIZE = 32;
+const int SKY_VIEW_WIDTH = 192;
+const int SKY_VIEW_HEIGHT = 108;
+const int AERIAL_SIZE = 32;
+const float AERIAL_MAX_DISTANCE = 32.0f;   // км — чуть дальше дальней плоскости отсечения
+
+// Перевод из единиц таблиц (освещённость от солнца = 1) в яркость сцены,
+// где белая поверхность под полуденным солнцем ~1; диск солнца ярче — его подхватывает bloom
+const float SKY_EXPOSURE = 8.0f;
+const float SUN_DISK_RADIANCE = 40.0f;
+// Когда пересчитывать таблицы: поворот солнца больше ~0.1° или смена высоты камеры на 0.1 км
+const float SUN_UPDATE_COS = 0.9999985f;
+const float HEIGHT_UPDATE_KM = 0.1f;
+
+// Параметры атмосферы Земли, километры (те же, что в ATMOSPHERE_GLSL)
+const float GROUND_RADIUS = 6360.0f;
+const float TOP_RADIUS = 6460.0f;
+const glm::vec3 RAYLEIGH_SCATTERING(5.802e-3f, 13.558e-3f, 33.1e-3f);
+const float RAYLEIGH_HEIGHT = 8.0f;
+const float MIE_EXTINCTION = 4.44e-3f;
+const float MIE_HEIGHT = 1.2f;
+const glm::vec3 OZONE_ABSORPTION(0.650e-3f, 1.881e-3f, 0.085e-3f);
+
+const char* versionGlsl = "#version 330 core\n";
+
+// Общая часть шейдеров таблиц: среда, фазовые функции, выборки из таблиц
+const char* atmosphereGlsl = R"(
+    const float PI = 3.14159265;
+    const float GROUND_RADIUS = 6360.0;
+    const float TOP_RADIUS = 6460.0;
+    const vec3 RAYLEIGH_SCATTERING = vec3(5.802, 13.558, 33.1) * 1e-3;
+    const float RAYLEIGH_HEIGHT = 8.0;
+    const float MIE_SCATTERING = 3.996e-3;
+    const float MIE_EXTINCTION = 4.44e-3;
+    const float MIE_HEIGHT = 1.2;
+    const float MIE_G = 0.8;
+    const vec3 OZONE_ABSORPTION = vec3(0.650, 1.881, 0.085) * 1e-3;
+    const vec3 GROUND_ALBEDO = vec3(0.25, 0.3, 0.2);
+
+    uniform sampler2D transmittanceLut;
+    uniform sampler2D multiScatteringLut;
+
+    struct Medium {
+        vec3 rayleigh;
+        float mie;
+        vec3 extinction;
+    };
+
+    Medium sampleMedium(vec3 position) {
+        float height = max(length(position) - GROUND_RADIUS, 0.0);
+        float rayleighDensity = exp(-height / RAYLEIGH_HEIGHT);
+        float mieDensity = exp(-height / MIE_HEIGHT);
+        float ozoneDensity = max(0.0, 1.0 - abs(height - 25.0) / 15.0);
+
+        Medium medium;
+        medium.rayleigh = RAYLEIGH_SCATTERING * rayleighDensity;
+        medium.mie = MIE_SCATTERING * mieDensity;
+        medium.extinction = medium.rayleigh + MIE_EXTINCTION * mieDensity + OZONE_ABSORPTION * ozoneDensity;
+        return medium;
+    }
+
+    float rayleighPhase(float cosTheta) {
+        return 3.0 / (16.0 * PI) * (1.0 + cosTheta * cosTheta);
+    }
+
+    // Cornette-Shanks
+    float miePhase(float cosTheta) {
+        float g2 = MIE_G * MIE_G;
+        float denominator = pow(max(1.0 + g2 - 2.0 * MIE_G * cosTheta, 1e-4), 1.5);
+        return 3.0 / (8.0 * PI) * (1.0 - g2) * (1.0 + cosTheta * cosTheta) / ((2.0 + g2) * denominator);
+    }
+
+    // Расстояние по лучу до сферы с центром в центре планеты; -1, если луч её не пересекает
+    float raySphere(vec3 origin, vec3 dir, float radius) {
+        float b = dot(origin, dir);
+        float c = dot(origin, origin) - radius * radius;
+        float discriminant = b * b - c;
+        if (discriminant < 0.0) {
+            return -1.0;
+        }
+        float root = sqrt(discriminant);
+        if (-b - root >= 0.0) {
+            return -b - root;
+        }
+        return -b + root >= 0.0 ? -b + root : -1.0;
+    }
+
+    // Таблицы с осями «косинус угла от зенита» × «высота»
+    vec2 zenithHeightUv(vec3 position, vec3 dir) {
+        float radius = length(position);
+        return vec2(dot(position / radius, dir) * 0.5 + 0.5, (radius - GROUND_RADIUS) / (TOP_RADIUS - GROUND_RADIUS));
+    }
+
+    vec3 transmittanceToSun(vec3 position, vec3 sunDir) {
+        if (raySphere(position, sunDir, GROUND_RADIUS) > 0.0) {
+            return vec3(0.0);   // Солнце за планетой
+        }
+        return texture(transmittanceLut, zenithHeightUv(position, sunDir)).rgb;
+    }
+
+    vec3 multipleScattering(vec3 position, vec3 sunDir) {
+        return texture(multiScatteringLut, zenithHeightUv(position, sunDir)).rgb;
+    }
+
+    // Одно- и многократное рассеяние вдоль луча длиной до maxDistance.
+    // Освещённость от солнца равна 1 — все таблицы в этих единицах
+    vec3 integrateScattering(vec3 origin, vec3 dir, vec3 sunDir, float maxDistance, int steps,
+                             bool groundBounce, out vec3 transmittance) {
+        float groundDistance = raySphere(origin, dir, GROUND_RADIUS);
+        float distance = groundDistance > 0.0 ? groundDistance : raySphere(origin, dir, TOP_RADIUS);
+        bool hitsGround = groundDistance > 0.0 && groundDistance <= maxDistance;
+        distance = max(min(distance, maxDistance), 0.0);
+
+        float cosTheta = dot(dir, sunDir);
+        float phaseRayleigh = rayleighPhase(cosTheta);
+        float phaseMie = miePhase(cosTheta);
+
+        vec3 luminance = vec3(0.0);
+        transmittance = vec3(1.0);
+        float previous = 0.0;
+        for (int i = 0; i < steps; ++i) {
+            // Шаги растут квадратично — у камеры мельче, к горизонту крупнее
+            float next = distance * pow((float(i) + 1.0) / float(steps), 2.0);
+            float dt = next - previous;
+            vec3 position = origin + dir * (previous + dt * 0.5);
+            previous = next;
+            position *= max(length(position), GROUND_RADIUS + 0.001) / length(position);
+
+            Medium medium = sampleMedium(position);
+            vec3 sunTransmittance = transmittanceToSun(position, sunDir);
+            vec3 multiple = multipleScattering(position, sunDir);
+            vec3 scattering = medium.rayleigh * (phaseRayleigh * sunTransmittance + multiple)
+                            + medium.mie * (phaseMie * sunTransmittance + multiple);
+
+            // Интеграл по отрезку с учётом ослабления внутри него
+            vec3 stepTransmittance = exp(-medium.extinction * dt);
+            luminance += transmittance * (scattering - scattering * stepTransmittance) / medium.extinction;
+            transmittance *= stepTransmittance;
+        }
+
+        if (groundBounce && hitsGround) {
+            vec3 position = origin + dir * groundDistance;
+            vec3 normal = normalize(position);
+            position = normal * (GROUND_RADIUS + 0.001);
+            luminance += transmittance * transmittanceToSun(position, sunDir)
+                       * max(dot(normal, sunDir), 0.0) * GROUND_ALBEDO / PI;
+        }
+        return luminance;
+    }
+
+    out vec4 FragColor;
+)";
+
+// Все таблицы рисуются одним треугольником на весь viewport
+const char* fullscreenVertexShader = R"(
+    #version 330 core
+    out vec2 ndc;
+
+    void main() {
+        ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+        gl_Position = vec4(ndc, 1.0, 1.0);   // z = w: глубина 1, небо за всей сценой
+    }
+)";
+
+// Пропускание от точки до верхней границы атмосферы
+const char* transmittanceShader = R"(
+    uniform vec2 lutSize;
+
+    void main() {
+        vec2 uv = gl_FragCoord.xy / lutSize;
+        float cosZenith = uv.x * 2.0 - 1.0;
+        vec3 origin = vec3(0.0, mix(GROUND_RADIUS, TOP_RADIUS, uv.y), 0.0);
+        vec3 dir = vec3(sqrt(max(0.0, 1.0 - cosZenith * cosZenith)), cosZenith, 0.0);
+
+        const int STEPS = 40;
+        float dt = max(raySphere(origin, dir, TOP_RADIUS), 0.0) / float(STEPS);
+        vec3 opticalDepth = vec3(0.0);
+        for (int i = 0; i < STEPS; ++i) {
+            opticalDepth += sampleMedium(origin + dir * (float(i) + 0.5) * dt).extinction * dt;
+        }
+        FragColor = vec4(exp(-opticalDepth), 1.0);
+    }
+)";
+
+// Многократное рассеяние: свет второго порядка, пришедший в точку со всей сферы,
+// и геометрическая прогрессия всех следующих порядков (Hillaire 2020, раздел 5.5)
+const char* multiScatteringShader = R"(
+    uniform vec2 lutSize;
+
+    void main() {
+        vec2 uv = gl_FragCoord.xy / lutSize;
+        float sunCosZenith = uv.x * 2.0 - 1.0;
+        vec3 origin = vec3(0.0, mix(GROUND_RADIUS + 0.01, TOP_RADIUS - 0.01, uv.y), 0.0);
+        vec3 sunDir = vec3(sqrt(max(0.0, 1.0 - sunCosZenith * sunCosZenith)), sunCosZenith, 0.0);
+
+        const int SQRT_SAMPLES = 8;
+        const int STEPS = 20;
+        vec3 luminance = vec3(0.0);
+        vec3 transfer = vec3(0.0);
+        for (int i = 0; i < SQRT_SAMPLES; ++i) {
+            for (int j = 0; j < SQRT_SAMPLES; ++j) {
+                // Равномерно по сфере
+                float theta = 2.0 * PI * (float(i) + 0.5) / float(SQRT_SAMPLES);
+                float phi = acos(1.0 - 2.0 * (float(j) + 0.5) / float(SQRT_SAMPLES));
+                vec3 dir = vec3(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta));
+
+                float groundDistance = raySphere(origin, dir, GROUND_RADIUS);
+                float distance = groundDistance > 0.0 ? groundDistance : raySphere(origin, dir, TOP_RADIUS);
+                float dt = distance / float(STEPS);
+                vec3 throughput = vec3(1.0);
+                for (int s = 0; s < STEPS; ++s) {
+                    vec3 position = origin + dir * (float(s) + 0.5) * dt;
+                    Medium medium = sampleMedium(position);
+                    vec3 scattering = medium.rayleigh + vec3(medium.mie);
+                    vec3 stepTransmittance = exp(-medium.extinction * dt);
+
+                    // Изотропная фаза 1/4π — в точку приходит свет со всех сторон
+                    vec3 sunScattering = transmittanceToSun(position, sunDir) * scattering / (4.0 * PI);
+                    luminance += throughput * (sunScattering - sunScattering * stepTransmittance) / medium.extinction;
+                    transfer += throughput * (scattering - scattering * stepTransmittance) / medium.extinction;
+                    throughput *= stepTransmittance;
+                }
+
+                if (groundDistance > 0.0) {
+                    vec3 normal = normalize(origin + dir * groundDistance);
+                    luminance += throughput * transmittanceToSun(normal * (GROUND_RADIUS + 0.001), sunDir)
+                               * max(dot(normal, sunDir), 0.0) * GROUND_ALBEDO / PI;
+                }
+            }
+        }
+
+        float count = float(SQRT_SAMPLES * SQRT_SAMPLES);
+        luminance /= count;
+        transfer /= count;
+        FragColor = vec4(luminance / (1.0 - transfer), 1.0);
+    }
+)";
+
+// Вид неба из точки над землёй: азимут от солнца (0..π, небо симметрично) ×
+// высота над горизонтом с квадратичным сгущением строк к горизонту
+const char* skyViewShader = R"(
+    uniform vec2 lutSize;
+    uniform vec3 sunDirection;
+    uniform float viewRadius;
+
+    void main() {
+        vec2 uv = gl_FragCoord.xy / lutSize;
+        float azimuth = uv.x * PI;
+        float t = uv.y * 2.0 - 1.0;
+        float elevation = sign(t) * t * t * PI * 0.5;
+
+        vec3 sunDir = vec3(sqrt(max(0.0, 1.0 - sunDirection.y * sunDirection.y)), sunDirection.y, 0.0);
+        vec3 dir = vec3(cos(elevation) * cos(azimuth), sin(elevation), cos(elevation) * sin(azimuth));
+
+        vec3 transmittance;
+        vec3 luminance = integrateScattering(vec3(0.0, viewRadius, 0.0), dir, sunDir, 1e9, 32, true, transmittance);
+        FragColor = vec4(luminance, 1.0);
+    }
+)";
+
+// Воздушная перспектива: свет, рассеянный между камерой и точкой на расстоянии
+// (слой по квадратичной шкале), и среднее пропускание до неё
+const char* aerialShader = R"(
+    uniform vec2 lutSize;
+    uniform float layer;
+    uniform float layerCount;
+    uniform float maxDistance;
+    uniform vec3 sunDirection;
+    uniform float viewRadius;
+
+    void main() {
+        vec2 uv = gl_FragCoord.xy / lutSize;
+        float w = (layer + 0.5) / layerCount;
+        float azimuth = uv.x * PI;
+        float elevation = (uv.y - 0.5) * PI;
+
+        vec3 sunDir = vec3(sqrt(max(0.0, 1.0 - sunDirection.y * sunDirection.y)), sunDirection.y, 0.0);
+        vec3 dir = vec3(cos(elevation) * cos(azimuth), sin(elevation), cos(elevation) * sin(azimuth));
+
+        vec3 transmittance;
+        vec3 luminance = integrateScattering(vec3(0.0, viewRadius, 0.0), dir, sunDir, maxDistance * w * w, 16, false, transmittance);
+        FragColor = vec4(luminance, dot(transmittance, vec3(1.0 / 3.0)));
+    }
+)";
+
+// Освещённость горизонтальной площадки от неба: интеграл таблицы вида неба по полусфере
+const char* irradianceShader = R"(
+    uniform sampler2D skyViewLut;
+
+    void main() {
+        const int ELEVATION_STEPS = 8;
+        const int AZIMUTH_STEPS = 16;
+        float elevationStep = 0.5 * PI / float(ELEVATION_STEPS);
+        float azimuthStep = PI / float(AZIMUTH_STEPS);
+
+        vec3 irradiance = vec3(0.0);
+        for (int e = 0; e < ELEVATION_STEPS; ++e) {
+            float elevation = (float(e) + 0.5) * elevationStep;
+            float v = 0.5 + 0.5 * sqrt(elevation / (0.5 * PI));
+            for (int a = 0; a < AZIMUTH_STEPS; ++a) {
+                float u = (float(a) + 0.5) / float(AZIMUTH_STEPS);
+                vec3 radiance = texture(skyViewLut, vec2(u, v)).rgb;
+                // cos от зенита × телесный угол ячейки
+                irradiance += radiance * sin(elevation) * cos(elevation) * elevationStep * azimuthStep;
+            }
+        }
+        // Таблица хранит половину неба по азимуту — вторая симметрична
+        FragColor = vec4(irradiance * 2.0, 1.0);
+    }
+)";
+
+const char* skyFragmentShader = R"(
+    #version 330 core
+    in vec2 ndc;
+    out vec4 FragColor;
+
+    const float PI = 3.14159265;
+    const vec3 NIGHT_SKY = vec3(0.01, 0.015, 0.03);
+
+    uniform sampler2D skyViewLut;
+    uniform mat4 inverseViewProjection;
+    uniform vec3 sunDirection;
+    uniform vec3 sunDisk;           // Яркость диска с учётом пропускания атмосферы
+    uniform float sunCosRadius;
+    uniform float skyExposure;
+
+    void main() {
+        vec4 nearPoint = inverseViewProjection * vec4(ndc, -1.0, 1.0);
+        vec4 farPoint = inverseViewProjection * vec4(ndc, 1.0, 1.0);
+        vec3 dir = normalize(farPoint.xyz / farPoint.w - nearPoint.xyz / nearPoint.w);
+
+        vec2 horizontal = vec2(dir.x, dir.z);
+        vec2 sunHorizontal = vec2(sunDirection.x, sunDirection.z);
+        float cosAzimuth = (length(horizontal) > 1e-4 && length(sunHorizontal) > 1e-4)
+            ? dot(normalize(horizontal), normalize(sunHorizontal)) : 1.0;
+        float elevation = asin(clamp(dir.y, -1.0, 1.0));
+        vec2 uv = vec2(acos(clamp(cosAzimuth, -1.0, 1.0)) / PI,
+                       0.5 + 0.5 * sign(elevation) * sqrt(abs(elevation) / (0.5 * PI)));
+
+        vec3 color = texture(skyViewLut, uv).rgb;
+        float disk = smoothstep(sunCosRadius, mix(sunCosRadius, 1.0, 0.3), dot(dir, sunDirection));
+        color += disk * sunDisk;
+        FragColor = vec4(max(color * skyExposure, NIGHT_SKY), 1.0);
+    }
+)";
+
+const char* aerialPerspectiveSource = R"(
+    const float AERIAL_PI = 3.14159265;
+    const float AERIAL_LAYERS = 32.0;
+    const vec3 NIGHT_AMBIENT = vec3(0.03, 0.035, 0.05);
+
+    uniform sampler3D aerialPerspectiveLut;
+    uniform sampler2D skyIrradianceLut;
+    uniform vec3 aerialSunDirection;
+    uniform vec3 aerialCameraPos;
+    uniform float aerialKmPerUnit;
+    uniform float aerialMaxDistance;
+    uniform float aerialExposure;
+
+    vec3 skyAmbient() {
+        return max(texture(skyIrradianceLut, vec2(0.5)).rgb, NIGHT_AMBIENT);
+    }
+
+    vec3 applyAerialPerspective(vec3 color, vec3 worldPos) {
+        vec3 ray = worldPos - aerialCameraPos;
+        float len = length(ray);
+        if (len < 1e-4) {
+            return color;
+        }
+        vec3 dir = ray / len;
+
+        vec2 horizontal = vec2(dir.x, dir.z);
+        vec2 sunHorizontal = vec2(aerialSunDirection.x, aerialSunDirection.z);
+        float cosAzimuth = (length(horizontal) > 1e-4 && length(sunHorizontal) > 1e-4)
+            ? dot(normalize(horizontal), normalize(sunHorizontal)) : 1.0;
+        float u = acos(clamp(cosAzimuth, -1.0, 1.0)) / AERIAL_PI;
+        float v = asin(clamp(dir.y, -1.0, 1.0)) / AERIAL_PI + 0.5;
+        float w = sqrt(clamp(len * aerialKmPerUnit / aerialMaxDistance, 0.0, 1.0));
+
+        vec4 aerial = texture(aerialPerspectiveLut, vec3(u, v, w));
+        // Ближе первого слоя таблицы дымка плавно сходит на нет
+        float weight = clamp(w * AERIAL_LAYERS, 0.0, 1.0);
+        return color * mix(1.0, aerial.a, weight) + aerial.rgb * aerialExposure * weight;
+    }
+)";
+
+GLuint compileShader(GLenum type, const char* const* sources, int count, const char* name) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, count, sources, nullptr);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << name << " shader compilation failed:\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+GLuint linkProgram(const char* const* fragmentSources, int fragmentCount, const char* name) {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, &fullscreenVertexShader, 1, name);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSources, fragmentCount, name);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << name << " program linking failed:\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+// Шейдер таблицы = версия + общая часть атмосферы + сама таблица
+GLuint linkLutProgram(const char* source, const char* name) {
+    const char* sources[] = {versionGlsl, atmosphereGlsl, source};
+    return linkProgram(sources, 3, name);
+}
+
+GLuint createLutTexture(GLenum target, int width, int height, int depth) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(target, texture);
+    if (target == GL_TEXTURE_3D) {
+        glTexImage3D(target, 0, GL_RGBA16F, width, height, depth, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    } else {
+        glTexImage2D(target, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(target, 0);
+    return texture;
+}
+
+// Пропускание от точки на высоте heightKm до солнца — то же, что в таблице, но на процессоре
+glm::vec3 atmosphereTransmittance(float heightKm, const glm::vec3& sunDirection) {
+    glm::vec3 origin(0.0f, GROUND_RADIUS + std::max(heightKm, 0.001f), 0.0f);
+    float b = glm::dot(origin, sunDirection);
+    float c = glm::dot(origin, origin) - GROUND_RADIUS * GROUND_RADIUS;
+    if (b < 0.0f && b * b - c >= 0.0f) {
+        return glm::vec3(0.0f);   // Солнце за горизонтом
+    }
+
+    float distance = -b + std::sqrt(b * b - (glm::dot(origin, origin) - TOP_RADIUS * TOP_RADIUS));
+    const int STEPS = 40;
+    float dt = distance / STEPS;
+    glm::vec3 opticalDepth(0.0f);
+    for (int i = 0; i < STEPS; ++i) {
+        glm::vec3 position = origin + sunDirection * ((i + 0.5f) * dt);
+        float height = std::max(glm::length(position) - GROUND_RADIUS, 0.0f);
+        float ozone = std::max(0.0f, 1.0f - std::abs(height - 25.0f) / 15.0f);
+        opticalDepth += (RAYLEIGH_SCATTERING * std::exp(-height / RAYLEIGH_HEIGHT)
+                         + glm::vec3(MIE_EXTINCTION * std::exp(-height / MIE_HEIGHT))
+                         + OZONE_ABSORPTION * ozone) * dt;
+    }
+    return glm::vec3(std::exp(-opticalDepth.x), std::exp(-opticalDepth.y), std::exp(-opticalDepth.z));
+}
+
+} // namespace
+
+glm::vec3 sunDirectionAt(float hours) {
+    // Солнце идёт по наклонённой на 30° дуге: с востока (+x) через юг к западу
+    const float tilt = glm::radians(30.0f);
+    float angle = (hours - 6.0f) / 12.0f * glm::pi<float>();
+    return glm::normalize(glm::vec3(cos(angle), sin(angle) * cos(tilt), sin(angle) * sin(tilt)));
+}
+
+const char* aerialPerspectiveGlsl() {
+    return aerialPerspectiveSource;
+}
+
+bool SkyAtmosphere::init() {
+    transmittanceProgram = linkLutProgram(transmittanceShader, "Sky transmittance");
+    multiScatteringProgram = linkLutProgram(multiScatteringShader, "Sky multiple scattering");
+    skyViewProgram = linkLutProgram(skyViewShader, "Sky view");
+    aerialProgram = linkLutProgram(aerialShader, "Aerial perspective");
+    const char* irradianceSources[] = {versionGlsl, "const float PI = 3.14159265;\nout vec4 FragColor;\n", irradianceShader};
+    irradianceProgram = linkProgram(irradianceSources, 3, "Sky irradiance");
+    skyProgram = linkProgram(&skyFragmentShader, 1, "Sky");
+
+    transmittanceLut = createLutTexture(GL_TEXTURE_2D, TRANSMITTANCE_WIDTH, TRANSMITTANCE_HEIGHT, 1);
+    multiScatteringLut = createLutTexture(GL_TEXTURE_2D, MULTI_SCATTERING_SIZE, MULTI_SCATTERING_SIZE, 1);
+    skyViewLut = createLutTexture(GL_TEXTURE_2D, SKY_VIEW_WIDTH, SKY_VIEW_HEIGHT, 1);
+    aerialLut = createLutTexture(GL_TEXTURE_3D, AERIAL_SIZE, AERIAL_SIZE, AERIAL_SIZE);
+    irradianceLut = createLutTexture(GL_TEXTURE_2D, 1, 1, 1);
+
+    glGenFramebuffers(1, &framebuffer);
+    glGenVertexArrays(1, &emptyVAO);
+
+    // Таблицы, не зависящие от солнца: сначала пропускание, по нему — многократное рассеяние
+    renderLut(transmittanceProgram, transmittanceLut, TRANSMITTANCE_WIDTH, TRANSMITTANCE_HEIGHT);
+    renderLut(multiScatteringProgram, multiScatteringLut, MULTI_SCATTERING_SIZE, MULTI_SCATTERING_SIZE);
+
+    valid = false;
+    return glGetError() == GL_NO_ERROR;
+}
+
+void SkyAtmosphere::destroy() {
+    GLuint textures[] = {transmittanceLut, multiScatteringLut, skyViewLut, aerialLut, irradianceLut};
+    glDeleteTextures(5, textures);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteVertexArrays(1, &emptyVAO);
+    for (GLuint program : {transmittanceProgram, multiScatteringProgram, skyViewProgram, aerialProgram, irradianceProgram, skyProgram}) {
+        glDeleteProgram(program);
+    }
+    transmittanceLut = multiScatteringLut = skyViewLut = aerialLut = irradianceLut = 0;
+    framebuffer = emptyVAO = 0;
+    valid = false;
+}
+
+// Таблицы атмосферы на блоки 0 и 1 — их читают все шейдеры таблиц
+void SkyAtmosphere::bindAtmosphereInputs(GLuint program) const {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, transmittanceLut);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, multiScatteringLut);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(program, "transmittanceLut"), 0);
+    glUniform1i(glGetUniformLocation(program, "multiScatteringLut"), 1);
+}
+
+void SkyAtmosphere::renderLut(GLuint program, GLuint texture, int width, int height, int layer) {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    if (layer >= 0) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0, layer);
+    } else {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glViewport(0, 0, width, height);
+
+    glUseProgram(program);
+    bindAtmosphereInputs(program);
+    glUniform2f(glGetUniformLocation(program, "lutSize"), float(width), float(height));
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (depthTest) {
+        glEnable(GL_DEPTH_TEST);
+    }
+    if (blend) {
+        glEnable(GL_BLEND);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool SkyAtmosphere::update(const glm::vec3& sunDirection, float cameraHeight) {
+    float heightKm = std::max(cameraHeight * SKY_KM_PER_UNIT, 0.0f);
+    if (valid && glm::dot(sunDirection, currentSun) > SUN_UPDATE_COS
+        && std::abs(heightKm - currentHeight) < HEIGHT_UPDATE_KM) {
+        return false;
+    }
+    currentSun = sunDirection;
+    currentHeight = heightKm;
+    sunTransmittance = atmosphereTransmittance(heightKm, sunDirection);
+    float viewRadius = GROUND_RADIUS + std::max(heightKm, 0.001f);
+
+    glUseProgram(skyViewProgram);
+    glUniform3fv(glGetUniformLocation(skyViewProgram, "sunDirection"), 1, glm::value_ptr(sunDirection));
+    glUniform1f(glGetUniformLocation(skyViewProgram, "viewRadius"), viewRadius);
+    renderLut(skyViewProgram, skyViewLut, SKY_VIEW_WIDTH, SKY_VIEW_HEIGHT);
+
+    glUseProgram(aerialProgram);
+    glUniform3fv(glGetUniformLocation(aerialProgram, "sunDirection"), 1, glm::value_ptr(sunDirection));
+    glUniform1f(glGetUniformLocation(aerialProgram, "viewRadius"), viewRadius);
+    glUniform1f(glGetUniformLocation(aerialProgram, "maxDistance"), AERIAL_MAX_DISTANCE);
+    glUniform1f(glGetUniformLocation(aerialProgram, "layerCount"), float(AERIAL_SIZE));
+    for (int layer = 0; layer < AERIAL_SIZE; ++layer) {
+        glUniform1f(glGetUniformLocation(aerialProgram, "layer"), float(layer));
+        renderLut(aerialProgram, aerialLut, AERIAL_SIZE, AERIAL_SIZE, layer);
+    }
+
+    // Освещённость читает только что посчитанный вид неба (блок 2)
+    glUseProgram(irradianceProgram);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, skyViewLut);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(irradianceProgram, "skyViewLut"), 2);
+    renderLut(irradianceProgram, irradianceLut, 1, 1);
+
+    valid = true;
+    ++updateCount;
+    return true;
+}
+
+void SkyAtmosphere::render(const glm::mat4& view, const glm::mat4& projection) {
+    glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+    // Диск чуть крупнее настоящего (0.27°), чтобы его было видно на экране
+    float sunCosRadius = cos(glm::radians(1.0f));
+    glm::vec3 sunDisk = sunTransmittance * SUN_DISK_RADIANCE;
+
+    glUseProgram(skyProgram);
+    glUniformMatrix4fv(glGetUniformLocation(skyProgram, "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+    glUniform3fv(glGetUniformLocation(skyProgram, "sunDirection"), 1, glm::value_ptr(currentSun));
+    glUniform3fv(glGetUniformLocation(skyProgram, "sunDisk"), 1, glm::value_ptr(sunDisk));
+    glUniform1f(glGetUniformLocation(skyProgram, "sunCosRadius"), sunCosRadius);
+    glUniform1f(glGetUniformLocation(skyProgram, "skyExposure"), SKY_EXPOSURE);
+    glUniform1i(glGetUniformLocation(skyProgram, "skyViewLut"), 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, skyViewLut);
+
+    // Только там, где глубину не тронули объекты
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
+
+void SkyAtmosphere::bindAerialPerspective(GLuint program, const glm::vec3& cameraPos, int aerialUnit, int irradianceUnit) const {
+    glActiveTexture(GL_TEXTURE0 + aerialUnit);
+    glBindTexture(GL_TEXTURE_3D, aerialLut);
+    glActiveTexture(GL_TEXTURE0 + irradianceUnit);
+    glBindTexture(GL_TEXTURE_2D, irradianceLut);
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform1i(glGetUniformLocation(program, "aerialPerspectiveLut"), aerialUnit);
+    glUniform1i(glGetUniformLocation(program, "skyIrradianceLut"), irradianceUnit);
+    glUniform3fv(glGetUniformLocation(program, "aerialSunDirection"), 1, glm::value_ptr(currentSun));
+    glUniform3fv(glGetUniformLocation(program, "aerialCameraPos"), 1, glm::value_ptr(cameraPos));
+    glUniform1f(glGetUniformLocation(program, "aerialKmPerUnit"), SKY_KM_PER_UNIT);
+    glUniform1f(glGetUniformLocation(program, "aerialMaxDistance"), AERIAL_MAX_DISTANCE);
+    glUniform1f(glGetUniformLocation(program, "aerialExposure"), SKY_EXPOSURE);
+}
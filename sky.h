@@ -0,0 +1,70 @@
+#pragma once
+
+// Небо и воздушная перспектива по физической модели рассеяния в атмосфере
+// (Rayleigh + Mie + озон, многократное рассеяние по Hillaire, 2020).
+// Таблицы считаются на видеокарте:
+// - пропускание атмосферы и многократное рассеяние — один раз при старте;
+// - вид неба, воздушная перспектива (направление × расстояние) и освещённость
+//   от неба — только когда сдвинулось солнце или заметно сменилась высота камеры.
+// В кадре небо — одна выборка из таблицы на пиксель, дымка на объектах —
+// одна выборка из трёхмерной таблицы в шейдере объекта (aerialPerspectiveGlsl).
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+const float SKY_KM_PER_UNIT = 0.05f;   // Масштаб сцены для атмосферы: дымка заметна уже на краю поля
+
+// Направление на солнце для времени суток в часах: восход в 6, полдень в 12, закат в 18
+glm::vec3 sunDirectionAt(float hours);
+
+// Кусок GLSL для шейдеров объектов (вставляется после объявлений, до main):
+//   vec3 applyAerialPerspective(vec3 color, vec3 worldPos) — дымка между камерой и точкой;
+//   vec3 skyAmbient() — рассеянный свет неба на горизонтальную площадку.
+// Uniform-переменные задаёт SkyAtmosphere::bindAerialPerspective
+const char* aerialPerspectiveGlsl();
+
+class SkyAtmosphere {
+public:
+    bool init();
+    void destroy();
+
+    // Пересчитывает зависящие от солнца таблицы, если есть что пересчитывать.
+    // Меняет буфер кадра и viewport — вызывать до начала отрисовки сцены
+    bool update(const glm::vec3& sunDirection, float cameraHeight);
+
+    // Небо там, где глубина не тронута; после непрозрачных объектов
+    void render(const glm::mat4& view, const glm::mat4& projection);
+
+    // Текстуры и uniform-переменные для шейдера с aerialPerspectiveGlsl()
+    void bindAerialPerspective(GLuint program, const glm::vec3& cameraPos, int aerialUnit, int irradianceUnit) const;
+
+    // Солнечный свет у земли (0..1 по каналам): белый в полдень, красный на закате, ноль ночью
+    glm::vec3 sunColor() const { return sunTransmittance; }
+    const glm::vec3& sunDirection() const { return currentSun; }
+    int lutUpdates() const { return updateCount; }
+
+private:
+    GLuint transmittanceLut = 0;
+    GLuint multiScatteringLut = 0;
+    GLuint skyViewLut = 0;
+    GLuint aerialLut = 0;        // 3D: азимут от солнца × высота над горизонтом × расстояние
+    GLuint irradianceLut = 0;    // 1×1: освещённость от неба
+    GLuint framebuffer = 0;
+    GLuint emptyVAO = 0;         // Полноэкранный треугольник строится из gl_VertexID
+
+    GLuint transmittanceProgram = 0;
+    GLuint multiScatteringProgram = 0;
+    GLuint skyViewProgram = 0;
+    GLuint aerialProgram = 0;
+    GLuint irradianceProgram = 0;
+    GLuint skyProgram = 0;
+
+    bool valid = false;
+    glm::vec3 currentSun = glm::vec3(0.0f, 1.0f, 0.0f);
+    float currentHeight = 0.0f;
+    glm::vec3 sunTransmittance = glm::vec3(1.0f);
+    int updateCount = 0;
+
+    void renderLut(GLuint program, GLuint texture, int width, int height, int layer = -1);
+    void bindAtmosphereInputs(GLuint program) const;
+};
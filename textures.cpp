@@ -0,0 +1,620 @@
+#include "textures.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const int UPLOAD_RING_SIZE = 8;               // Слотов PBO в кольце
+const size_t MIN_SLOT_SIZE = 64 * 1024;       // Строка блоков BC7 шириной 16384 — ровно 64 КБ
+const float UNSEEN_GRACE = 2.0f;              // Через сколько секунд без touch() текстура считается невидимой
+const float UNSEEN_SIZE = 32.0f;              // До какого размера ужимаются невидимые текстуры
+const float DROP_DELAY = 1.0f;                // Задержка перед понижением детализации (против дрожания)
+
+// Значения из спецификаций KTX2 (VkFormat) и DDS (DXGI_FORMAT)
+const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+const uint32_t VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132;
+const uint32_t VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133;
+const uint32_t VK_FORMAT_BC1_RGBA_SRGB_BLOCK = 134;
+const uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+const uint32_t VK_FORMAT_BC3_SRGB_BLOCK = 138;
+const uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+const uint32_t VK_FORMAT_BC7_SRGB_BLOCK = 146;
+
+const uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+const uint32_t DXGI_FORMAT_BC1_UNORM_SRGB = 72;
+const uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+const uint32_t DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+const uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+const uint32_t DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+
+const uint32_t DDS_MAGIC = 0x20534444;       // "DDS "
+const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+const uint32_t DDPF_FOURCC = 0x4;
+const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+const uint32_t DDSCAPS2_VOLUME = 0x200000;
+
+const uint8_t KTX2_MAGIC[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+uint32_t fourCC(char a, char b, char c, char d) {
+    return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+// Файлы little-endian, как и все целевые платформы
+template <typename T>
+bool readValue(const std::vector<uint8_t>& bytes, size_t offset, T& value) {
+    if (offset > bytes.size() || bytes.size() - offset < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return true;
+}
+
+size_t levelSize(int width, int height, int blockBytes) {
+    return size_t((width + 3) / 4) * size_t((height + 3) / 4) * blockBytes;
+}
+
+// sRGB-варианты грузятся как обычные: сцена освещается без sRGB-буфера кадра,
+// цвета вершин тоже заданы «как есть», и текстуры должны с ними совпадать
+bool formatFromVulkan(uint32_t vkFormat, TextureData& out) {
+    switch (vkFormat) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            out.format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; out.blockBytes = 8; return true;
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            out.format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; out.blockBytes = 8; return true;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+            out.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; out.blockBytes = 16; return true;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            out.format = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB; out.blockBytes = 16; return true;
+    }
+    return false;
+}
+
+bool formatFromDxgi(uint32_t dxgiFormat, TextureData& out) {
+    switch (dxgiFormat) {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            out.format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; out.blockBytes = 8; return true;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            out.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; out.blockBytes = 16; return true;
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            out.format = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB; out.blockBytes = 16; return true;
+    }
+    return false;
+}
+
+bool formatSupported(GLenum format) {
+    if (format == GL_COMPRESSED_RGBA_BPTC_UNORM_ARB) {
+        return GLEW_ARB_texture_compression_bptc || GLEW_VERSION_4_2;
+    }
+    return GLEW_EXT_texture_compression_s3tc;
+}
+
+bool parseKtx2(TextureData& out, std::string& error) {
+    const std::vector<uint8_t>& bytes = out.bytes;
+    uint32_t vkFormat, width, height, depth, layers, faces, levelCount, supercompression;
+    if (!readValue(bytes, 12, vkFormat) || !readValue(bytes, 20, width) || !readValue(bytes, 24, height) ||
+        !readValue(bytes, 28, depth) || !readValue(bytes, 32, layers) || !readValue(bytes, 36, faces) ||
+        !readValue(bytes, 40, levelCount) || !readValue(bytes, 44, supercompression)) {
+        error = "truncated KTX2 header";
+        return false;
+    }
+    if (!formatFromVulkan(vkFormat, out)) {
+        error = "unsupported KTX2 format " + std::to_string(vkFormat) + " (expected BC1/BC3/BC7)";
+        return false;
+    }
+    if (supercompression != 0) {
+        error = "supercompressed KTX2 is not supported";
+        return false;
+    }
+    if (depth > 1 || layers > 1 || faces != 1 || width == 0 || height == 0) {
+        error = "only plain 2D KTX2 textures are supported";
+        return false;
+    }
+
+    // Индекс уровней идёт сразу за заголовком: offset, length, uncompressedLength (по 8 байт)
+    levelCount = std::max(levelCount, 1u);
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        uint64_t offset, length;
+        if (!readValue(bytes, 80 + i * 24, offset) || !readValue(bytes, 80 + i * 24 + 8, length)) {
+            error = "truncated KTX2 level index";
+            return false;
+        }
+
+        TextureMipLevel level;
+        level.width = std::max(1, int(width >> i));
+        level.height = std::max(1, int(height >> i));
+        level.offset = size_t(offset);
+        level.size = levelSize(level.width, level.height, out.blockBytes);
+        if (length < level.size || offset > bytes.size() || bytes.size() - offset < level.size) {
+            error = "KTX2 level " + std::to_string(i) + " is out of file bounds";
+            return false;
+        }
+        out.levels.push_back(level);
+    }
+    return true;
+}
+
+bool parseDds(TextureData& out, std::string& error) {
+    const std::vector<uint8_t>& bytes = out.bytes;
+    uint32_t headerSize, flags, height, width, mipCount, pixelFlags, code, caps2;
+    if (!readValue(bytes, 4, headerSize) || !readValue(bytes, 8, flags) || !readValue(bytes, 12, height) ||
+        !readValue(bytes, 16, width) || !readValue(bytes, 28, mipCount) || !readValue(bytes, 80, pixelFlags) ||
+        !readValue(bytes, 84, code) || !readValue(bytes, 112, caps2) || headerSize != 124) {
+        error = "truncated DDS header";
+        return false;
+    }
+    if ((caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) || width == 0 || height == 0) {
+        error = "only plain 2D DDS textures are supported";
+        return false;
+    }
+    if (!(pixelFlags & DDPF_FOURCC)) {
+        error = "uncompressed DDS is not supported";
+        return false;
+    }
+
+    size_t offset = 4 + 124;
+    if (code == fourCC('D', 'X', 'T', '1')) {
+        out.format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        out.blockBytes = 8;
+    } else if (code == fourCC('D', 'X', 'T', '5')) {
+        out.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        out.blockBytes = 16;
+    } else if (code == fourCC('D', 'X', '1', '0')) {
+        uint32_t dxgiFormat, arraySize;
+        if (!readValue(bytes, offset, dxgiFormat) || !readValue(bytes, offset + 12, arraySize)) {
+            error = "truncated DDS DX10 header";
+            return false;
+        }
+        if (!formatFromDxgi(dxgiFormat, out)) {
+            error = "unsupported DXGI format " + std::to_string(dxgiFormat) + " (expected BC1/BC3/BC7)";
+            return false;
+        }
+        if (arraySize > 1) {
+            error = "DDS texture arrays are not supported";
+            return false;
+        }
+        offset += 20;
+    } else {
+        error = "unsupported DDS compression (expected DXT1/DXT5/DX10)";
+        return false;
+    }
+
+    // Уровни лежат подряд, от самого детального
+    int levelCount = (flags & DDSD_MIPMAPCOUNT) ? std::max(1u, mipCount) : 1;
+    for (int i = 0; i < levelCount; ++i) {
+        TextureMipLevel level;
+        level.width = std::max(1, int(width >> i));
+        level.height = std::max(1, int(height >> i));
+        level.offset = offset;
+        level.size = levelSize(level.width, level.height, out.blockBytes);
+        if (offset > bytes.size() || bytes.size() - offset < level.size) {
+            error = "DDS level " + std::to_string(i) + " is out of file bounds";
+            return false;
+        }
+        out.levels.push_back(level);
+        offset += level.size;
+    }
+    return true;
+}
+
+} // namespace
+
+bool loadCompressedTexture(const std::string& path, TextureData& out, std::string& error) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        error = "file not found";
+        return false;
+    }
+    std::streamsize fileSize = file.tellg();
+    file.seekg(0);
+    out.bytes.resize(size_t(fileSize));
+    if (!file.read(reinterpret_cast<char*>(out.bytes.data()), fileSize)) {
+        error = "read error";
+        return false;
+    }
+
+    uint32_t magic = 0;
+    readValue(out.bytes, 0, magic);
+    if (out.bytes.size() >= sizeof(KTX2_MAGIC) && std::memcmp(out.bytes.data(), KTX2_MAGIC, sizeof(KTX2_MAGIC)) == 0) {
+        return parseKtx2(out, error);
+    }
+    if (magic == DDS_MAGIC) {
+        return parseDds(out, error);
+    }
+    error = "unknown file format (expected KTX2 or DDS)";
+    return false;
+}
+
+bool TextureStreamer::init(size_t residencyBudgetBytes, size_t uploadBudgetBytes) {
+    residencyBudget = residencyBudgetBytes;
+    uploadBudget = uploadBudgetBytes;
+    slotSize = std::max(MIN_SLOT_SIZE, uploadBudget / 4);
+
+    // Заглушка для ещё не загруженных и отсутствующих текстур
+    const uint8_t white[4] = {255, 255, 255, 255};
+    glGenTextures(1, &fallback);
+    glBindTexture(GL_TEXTURE_2D, fallback);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (GLEW_EXT_texture_filter_anisotropic) {
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+        maxAnisotropy = std::min(maxAnisotropy, 8.0f);
+    }
+
+    ring.resize(UPLOAD_RING_SIZE);
+    for (auto& slot : ring) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, slotSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    stopping = false;
+    loader = std::thread(&TextureStreamer::loaderLoop, this);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+void TextureStreamer::destroy() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (loader.joinable()) {
+        loader.join();
+    }
+
+    for (auto& entry : entries) {
+        if (entry.building && entry.building != entry.texture) {
+            releaseTexture(entry, entry.building, entry.buildBase);
+        }
+        if (entry.texture) {
+            releaseTexture(entry, entry.texture, entry.textureBase);
+        }
+    }
+    entries.clear();
+
+    for (auto& slot : ring) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+        }
+        glDeleteBuffers(1, &slot.buffer);
+    }
+    ring.clear();
+
+    glDeleteTextures(1, &fallback);
+    fallback = 0;
+}
+
+int TextureStreamer::request(const std::string& path) {
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].path == path) {
+            return static_cast<int>(i);
+        }
+    }
+
+    int handle = static_cast<int>(entries.size());
+    entries.push_back(Entry());
+    entries.back().path = path;
+    uploadOrder.reserve(entries.size());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        loadQueue.emplace_back(handle, path);
+    }
+    wake.notify_one();
+    return handle;
+}
+
+void TextureStreamer::touch(int handle, float screenSize) {
+    if (handle >= 0 && handle < static_cast<int>(entries.size())) {
+        entries[handle].screenSize = std::max(entries[handle].screenSize, screenSize);
+    }
+}
+
+GLuint TextureStreamer::texture(int handle) const {
+    if (handle < 0 || handle >= static_cast<int>(entries.size()) || entries[handle].texture == 0) {
+        return fallback;
+    }
+    return entries[handle].texture;
+}
+
+void TextureStreamer::loaderLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !loadQueue.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        std::pair<int, std::string> job = std::move(loadQueue.front());
+        loadQueue.pop_front();
+        lock.unlock();
+
+        // Чтение и разбор файла — без блокировки, основной поток в это время рисует
+        LoadResult result;
+        result.handle = job.first;
+        if (loadCompressedTexture(job.second, result.data, result.error)) {
+            size_t levelCount = result.data.levels.size();
+            result.chainBytes.assign(levelCount + 1, 0);
+            for (size_t i = levelCount; i > 0; --i) {
+                result.chainBytes[i - 1] = result.chainBytes[i] + result.data.levels[i - 1].size;
+            }
+        } else {
+            result.data = TextureData();
+        }
+
+        lock.lock();
+        loadedQueue.push_back(std::move(result));
+    }
+}
+
+void TextureStreamer::acceptLoaded() {
+    std::vector<LoadResult> results;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.swap(loadedQueue);
+    }
+
+    for (auto& result : results) {
+        Entry& entry = entries[result.handle];
+        if (result.error.empty() && !formatSupported(result.data.format)) {
+            result.error = "compressed format is not supported by the GPU";
+        }
+        if (!result.error.empty()) {
+            std::cerr << "Texture " << entry.path << ": " << result.error << ", using fallback" << std::endl;
+            continue;
+        }
+
+        entry.data = std::move(result.data);
+        entry.chainBytes = std::move(result.chainBytes);
+        entry.loaded = true;
+
+        int levelCount = static_cast<int>(entry.data.levels.size());
+        // Пока ничего не залито: «резидентный» уровень за пределами цепочки
+        entry.textureBase = levelCount;
+        entry.residentBase = levelCount;
+        entry.wantedBase = levelCount - 1;
+    }
+}
+
+void TextureStreamer::chooseResidency(float deltaTime) {
+    size_t total = 0;
+
+    // Желаемый уровень: самый грубый, который ещё не меньше экранного размера объекта
+    for (auto& entry : entries) {
+        if (!entry.loaded) {
+            continue;
+        }
+        if (entry.screenSize > 0.0f) {
+            entry.unseenTime = 0.0f;
+            entry.lastScreenSize = entry.screenSize;
+        } else {
+            entry.unseenTime += deltaTime;
+        }
+        entry.screenSize = 0.0f;
+
+        float size = entry.unseenTime < UNSEEN_GRACE ? std::max(entry.lastScreenSize, UNSEEN_SIZE) : UNSEEN_SIZE;
+        const auto& levels = entry.data.levels;
+        int base = 0;
+        while (base + 1 < static_cast<int>(levels.size()) &&
+               std::max(levels[base + 1].width, levels[base + 1].height) >= size) {
+            ++base;
+        }
+        entry.wantedBase = base;
+        total += entry.chainBytes[base];
+    }
+
+    // Не влезаем в бюджет — урезаем текстуру с наибольшим избытком текселей на пиксель экрана.
+    // Невидимые объекты имеют размер 0 и отдают память первыми
+    while (total > residencyBudget) {
+        Entry* victim = nullptr;
+        float worstRatio = 0.0f;
+        for (auto& entry : entries) {
+            if (!entry.loaded || entry.wantedBase + 1 >= static_cast<int>(entry.data.levels.size())) {
+                continue;
+            }
+            const TextureMipLevel& level = entry.data.levels[entry.wantedBase];
+            float size = entry.unseenTime < UNSEEN_GRACE ? entry.lastScreenSize : 0.0f;
+            float ratio = std::max(level.width, level.height) / std::max(size, 1.0f);
+            if (ratio > worstRatio) {
+                worstRatio = ratio;
+                victim = &entry;
+            }
+        }
+        if (!victim) {
+            break;
+        }
+        total -= victim->data.levels[victim->wantedBase].size;
+        ++victim->wantedBase;
+    }
+
+    // Повышение детализации — сразу, понижение — если желание держится DROP_DELAY секунд
+    for (auto& entry : entries) {
+        if (!entry.loaded) {
+            continue;
+        }
+        int target = entry.building ? entry.buildBase : entry.textureBase;
+        if (entry.wantedBase < target) {
+            entry.coarserTime = 0.0f;
+            startBuild(entry, entry.wantedBase);
+        } else if (entry.wantedBase > target) {
+            entry.coarserTime += deltaTime;
+            if (entry.coarserTime >= DROP_DELAY) {
+                entry.coarserTime = 0.0f;
+                startBuild(entry, entry.wantedBase);
+            }
+        } else {
+            entry.coarserTime = 0.0f;
+        }
+    }
+}
+
+GLuint TextureStreamer::createTexture(const Entry& entry, int base) {
+    const TextureData& data = entry.data;
+    int lastLevel = static_cast<int>(data.levels.size()) - 1;
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // Память под все уровни сразу, данные придут через PBO.
+    // Без привязанного PBO nullptr означает «без данных», а не смещение 0
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    for (int i = base; i <= lastLevel; ++i) {
+        const TextureMipLevel& level = data.levels[i];
+        glCompressedTexImage2D(GL_TEXTURE_2D, i - base, data.format, level.width, level.height, 0,
+                               static_cast<GLsizei>(level.size), nullptr);
+    }
+
+    // Пока не залит ни один уровень, текстура не сэмплируется; BASE_LEVEL сдвигается по мере заливки
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, lastLevel - base);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel - base);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    if (maxAnisotropy > 1.0f) {
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAnisotropy);
+    }
+
+    allocatedBytes += entry.chainBytes[base];
+    return texture;
+}
+
+void TextureStreamer::releaseTexture(const Entry& entry, GLuint texture, int base) {
+    glDeleteTextures(1, &texture);
+    allocatedBytes -= entry.chainBytes[base];
+}
+
+void TextureStreamer::startBuild(Entry& entry, int base) {
+    // Недостроенную замену выбрасываем; если она уже показывается, она остаётся в texture
+    if (entry.building && entry.building != entry.texture) {
+        releaseTexture(entry, entry.building, entry.buildBase);
+    }
+
+    entry.building = createTexture(entry, base);
+    entry.buildBase = base;
+    entry.uploadLevel = static_cast<int>(entry.data.levels.size()) - 1;   // Сначала грубые уровни
+    entry.uploadRow = 0;
+}
+
+void TextureStreamer::finishLevel(Entry& entry) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.uploadLevel - entry.buildBase);
+
+    // Подменяем показываемую текстуру, как только новая не хуже её (или когда её не было)
+    if (entry.building != entry.texture &&
+        (entry.uploadLevel <= entry.residentBase || entry.uploadLevel == entry.buildBase)) {
+        if (entry.texture) {
+            releaseTexture(entry, entry.texture, entry.textureBase);
+        }
+        entry.texture = entry.building;
+        entry.textureBase = entry.buildBase;
+    }
+    if (entry.building == entry.texture) {
+        entry.residentBase = entry.uploadLevel;
+    }
+
+    if (entry.uploadLevel == entry.buildBase) {
+        entry.building = 0;
+    } else {
+        --entry.uploadLevel;
+        entry.uploadRow = 0;
+    }
+}
+
+bool TextureStreamer::uploadChunk(Entry& entry, size_t& budget) {
+    const TextureData& data = entry.data;
+    const TextureMipLevel& level = data.levels[entry.uploadLevel];
+
+    // Уровень режется на полосы из целых строк блоков 4x4 — их данные лежат подряд
+    size_t rowBytes = size_t((level.width + 3) / 4) * data.blockBytes;
+    int blockRows = (level.height + 3) / 4;
+    int rows = std::min(blockRows - entry.uploadRow, static_cast<int>(std::min(slotSize, budget) / rowBytes));
+    if (rows <= 0) {
+        return false;
+    }
+
+    UploadSlot& slot = ring[nextSlot];
+    if (slot.fence) {
+        // Видеокарта ещё читает этот слот — не ждём, продолжим в следующем кадре
+        if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            return false;
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+    }
+
+    size_t bytes = rows * rowBytes;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!destination) {
+        return false;
+    }
+    std::memcpy(destination, data.bytes.data() + level.offset + entry.uploadRow * rowBytes, bytes);
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) != GL_TRUE) {
+        return false;   // Содержимое потеряно — повторим эту полосу
+    }
+
+    int y = entry.uploadRow * 4;
+    glBindTexture(GL_TEXTURE_2D, entry.building);
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, entry.uploadLevel - entry.buildBase, 0, y,
+                              level.width, std::min(rows * 4, level.height - y),
+                              data.format, static_cast<GLsizei>(bytes), nullptr);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    nextSlot = (nextSlot + 1) % static_cast<int>(ring.size());
+
+    budget -= bytes;
+    entry.uploadRow += rows;
+    if (entry.uploadRow == blockRows) {
+        finishLevel(entry);
+    }
+    return true;
+}
+
+void TextureStreamer::update(float deltaTime) {
+    acceptLoaded();
+    chooseResidency(deltaTime);
+
+    // Первыми заливаются текстуры самых крупных на экране объектов
+    uploadOrder.clear();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].building) {
+            uploadOrder.push_back(static_cast<int>(i));
+        }
+    }
+    std::sort(uploadOrder.begin(), uploadOrder.end(), [this](int a, int b) {
+        return entries[a].lastScreenSize > entries[b].lastScreenSize;
+    });
+
+    size_t budget = uploadBudget;
+    for (int handle : uploadOrder) {
+        Entry& entry = entries[handle];
+        while (entry.building) {
+            if (!uploadChunk(entry, budget)) {
+                budget = 0;
+                break;
+            }
+        }
+        if (budget == 0) {
+            break;
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
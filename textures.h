@@ -0,0 +1,124 @@
+#pragma once
+
+// Потоковая загрузка сжатых текстур (BC1/BC3/BC7 из KTX2 или DDS с готовыми мип-уровнями).
+// - Файлы читает и разбирает фоновый поток, запуск игры не ждёт диска.
+// - Пока текстура не загружена, вместо неё выдаётся белая 1x1 — цвет вершин не меняется.
+// - Мип-уровни передаются на видеокарту через кольцо PBO: не больше
+//   uploadBudget байт за кадр, слот переиспользуется только после его fence.
+// - Бюджет видеопамяти: у далёких и невидимых объектов отбрасываются
+//   старшие мип-уровни, пока сумма не уложится в residencyBudget.
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+const int NO_TEXTURE = -1;
+
+struct TextureMipLevel {
+    size_t offset;   // Смещение данных уровня в TextureData::bytes
+    size_t size;
+    int width;
+    int height;
+};
+
+// Разобранный файл текстуры: уровни от самого детального к самому грубому
+struct TextureData {
+    GLenum format = 0;
+    int blockBytes = 0;   // 8 для BC1, 16 для BC3/BC7
+    std::vector<uint8_t> bytes;
+    std::vector<TextureMipLevel> levels;
+};
+
+// Формат определяется по сигнатуре файла, а не по расширению
+bool loadCompressedTexture(const std::string& path, TextureData& out, std::string& error);
+
+class TextureStreamer {
+public:
+    bool init(size_t residencyBudgetBytes, size_t uploadBudgetBytes);
+    void destroy();
+
+    // Возвращает дескриптор сразу; до окончания загрузки texture() отдаёт заглушку
+    int request(const std::string& path);
+
+    // Сколько пикселей экрана занимает объект с этой текстурой в текущем кадре.
+    // Текстуры, которые давно не отмечались, считаются невидимыми
+    void touch(int handle, float screenSize);
+
+    // Раз в кадр: принять загруженные файлы, пересчитать резидентность, отправить порцию данных
+    void update(float deltaTime);
+
+    GLuint texture(int handle) const;
+    size_t residentBytes() const { return allocatedBytes; }
+
+private:
+    struct Entry {
+        std::string path;
+        TextureData data;
+        bool loaded = false;
+        std::vector<size_t> chainBytes;   // Размер цепочки от уровня i до самого грубого
+
+        GLuint texture = 0;               // То, что сейчас сэмплируется (0 — заглушка)
+        int textureBase = 0;              // Уровень файла, ставший нулевым уровнем texture
+        int residentBase = 0;             // Самый детальный уже залитый уровень texture
+
+        GLuint building = 0;              // Собираемая текстура (может совпадать с texture)
+        int buildBase = 0;                // Её самый детальный уровень
+        int uploadLevel = 0;              // Уровень, который сейчас заливается
+        int uploadRow = 0;                // Следующая строка блоков 4x4 в этом уровне
+
+        float screenSize = 0.0f;          // Максимум за текущий кадр
+        float lastScreenSize = 0.0f;
+        float unseenTime = 0.0f;
+        float coarserTime = 0.0f;         // Сколько уже хотим уровень грубее текущего
+        int wantedBase = 0;
+    };
+
+    struct UploadSlot {
+        GLuint buffer = 0;
+        GLsync fence = 0;
+    };
+
+    // Всё, что требует памяти, готовится на потоке загрузчика
+    struct LoadResult {
+        int handle;
+        TextureData data;
+        std::vector<size_t> chainBytes;
+        std::string error;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<UploadSlot> ring;
+    size_t slotSize = 0;
+    int nextSlot = 0;
+    size_t residencyBudget = 0;
+    size_t uploadBudget = 0;
+    size_t allocatedBytes = 0;
+    GLuint fallback = 0;
+    float maxAnisotropy = 1.0f;
+
+    // Фоновый загрузчик
+    std::thread loader;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::pair<int, std::string>> loadQueue;
+    std::vector<LoadResult> loadedQueue;
+    bool stopping = false;
+
+    std::vector<int> uploadOrder;
+
+    void loaderLoop();
+    void acceptLoaded();
+    void chooseResidency(float deltaTime);
+    void startBuild(Entry& entry, int base);
+    bool uploadChunk(Entry& entry, size_t& budget);
+    void finishLevel(Entry& entry);
+    GLuint createTexture(const Entry& entry, int base);
+    void releaseTexture(const Entry& entry, GLuint texture, int base);
+};